@@ -0,0 +1,71 @@
+//
+//  alloc_counter.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/11/22.
+//
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "benchmark.h"
+
+// Replaces the global operator new of the program, so the checks can tell that a code path doesn't allocate.
+// The count is one relaxed increment per allocation, it doesn't change what it measures.
+// Only the checks build (-DEXCHANGE_CHECKS) replaces it; every other build keeps the standard allocator.
+
+#ifdef EXCHANGE_CHECKS
+
+static std::atomic<std::size_t> allocations{0};
+
+std::size_t bench::allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return ::operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#endif // EXCHANGE_CHECKS
@@ -0,0 +1,112 @@
+/// @file benchmark.h
+/// @brief This is a file to declare the micro benchmarks of the exchange prototype.
+/// @author Shangwen Sun
+/// @date 04/26/2022
+
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "types.h"
+#include "arena.h"
+#include "spsc_ring.h"
+
+namespace bench
+{
+
+/// @brief A steady clock stopwatch started on construction.
+class Stopwatch
+{
+public:
+    Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+    
+    /// @brief seconds elapsed since construction
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+    
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+/// @brief Silence std::cout while in scope, so the book's console output doesn't dominate the measurement.
+class MuteStdout
+{
+public:
+    MuteStdout() { std::cout.setstate(std::ios::badbit); }
+    ~MuteStdout() { std::cout.clear(); }
+};
+
+/// @brief print one benchmark result as nanoseconds and operations per second
+inline void report(const std::string& name, std::size_t operations, double seconds)
+{
+    std::cout << name << ": " << operations << " ops, "
+              << seconds * 1e9 / operations << " ns/op, "
+              << operations / seconds << " ops/s" << std::endl;
+}
+
+/// @brief find the next non-empty level across gaps of `gap` ticks, with the occupancy bitmap and with a linear walk
+void level_lookup(std::size_t levels, lib::t_tick_index gap);
+
+/// @brief sweep `levels` ask levels spaced `gap` ticks apart with one market buy order
+void wide_gap_sweep(std::size_t levels, lib::t_tick_index gap, std::size_t rounds);
+
+/// @brief fill rate of aggressive orders each filling `fills_per_order` resting orders spread over 64 levels, on both sides
+void fill_throughput(std::size_t resting, std::size_t fills_per_order, std::size_t rounds);
+
+/// @brief the fill throughput of a book without a listener, and of one recording its events into the binary feed,
+///        counted in memory and written by the asynchronous writer
+void listener_overhead(std::size_t resting, std::size_t fills_per_order, std::size_t rounds);
+
+/// @brief fill rate against a book of iceberg orders showing 100 out of 1000, where most fills replenish a slice
+void iceberg_throughput(std::size_t resting, std::size_t fills_per_order, std::size_t rounds);
+
+/// @brief check and index `prices` prices spread over five tick bands, with the former floating point
+///        and band walk code and with the compiled integer bands
+void tick_lookup(std::size_t prices);
+
+/// @brief construction time of `books` default sized order books, and the time of the first order added to each
+void book_startup(std::size_t books, const lib::ArenaOptions& options);
+
+/// @brief replay a request file through the matching pipeline with 1, 2, ... max_shards matching shards
+void pipeline_replay(const lib::FILE& order_request_file_name, const lib::FILE& config_file_name, std::size_t max_shards, lib::WaitStrategy wait_strategy);
+
+/// @brief generate `orders` requests over `symbols` symbols with a Zipf(`exponent`) mix, then match them
+///        on `threads` static pipeline shards, on rebalanced shards and on a work-stealing pool of `threads` workers
+void zipf_replay(std::size_t symbols, std::size_t orders, double exponent, std::size_t threads, const lib::FILE& config_file_name);
+
+/// @brief decode a request file with the streaming parser, then with the chunked parser on 1, 2, ... max_threads threads
+void parse_throughput(const lib::FILE& order_request_file_name, const lib::FILE& config_file_name, std::size_t max_threads);
+
+/// @brief decode the lines of a request file repeated `copies` times, with a json document per line and with the OrderDecoder
+void decode_throughput(const lib::FILE& order_request_file_name, const lib::FILE& config_file_name, std::size_t copies);
+
+/// @brief validate `lines` decoded but invalid orders, throwing an exception per reject and counting rejects by reason
+void reject_throughput(const lib::FILE& config_file_name, std::size_t lines);
+
+/// @brief convert a request file to the binary order format, then read and match it as json lines and as binary messages
+void wire_throughput(const lib::FILE& order_request_file_name, const lib::FILE& config_file_name);
+
+/// @brief publish `events` book events through the json notifier and through the binary feed encoder
+void feed_throughput(std::size_t events);
+
+/// @brief encode `events` feed messages in batches of `batch_messages` and publish them by reopening a file per batch,
+///        by a stream on the encoding thread and by the asynchronous writer, waiting and dropping under backpressure
+void publisher_throughput(std::size_t events, std::size_t batch_messages);
+
+#ifdef EXCHANGE_CHECKS
+/// @brief number of heap allocations of the program so far, counted by the operator new alloc_counter.cpp replaces
+std::size_t allocation_count();
+#endif
+
+/// @brief parse and format `prices` random prices with the floating point conversions and with Price4's exact ones
+void price_codec(std::size_t prices);
+
+/// @brief run the checks of the book and market data paths, printing the result of each
+/// @return true if every check passed
+bool run_checks();
+
+} // namespace bench
@@ -0,0 +1,292 @@
+//
+//  book_bench.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 4/26/22.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "book.h"
+#include "level_store.h"
+#include "ticks.h"
+#include "recording_listener.h"
+#include "async_publisher.h"
+#include "benchmark.h"
+
+using namespace bench;
+
+namespace
+{
+
+/// @brief rest `resting` orders over 64 levels, then fill them with aggressive orders of `fills_per_order` fills each,
+///        alternating the sides every round
+/// @return seconds spent in the aggressive orders
+template <class Book>
+double fill_rounds(Book& book, std::size_t resting, std::size_t fills_per_order, std::size_t rounds)
+{
+    const lib::t_price base = 1000000;
+    const lib::t_quantity aggressive_qty = static_cast<lib::t_quantity>(fills_per_order) * 100;
+    lib::t_orderid order_id = 0;
+    double seconds = 0;
+    
+    MuteStdout mute;
+    for (std::size_t round = 0; round < rounds; ++round)
+    {
+        const bool resting_buy = round % 2;
+        for (std::size_t i = 0; i < resting; ++i)
+            book.add(lob::Order(1, "BENCH", ++order_id, resting_buy, base + static_cast<lib::t_price>(i % 64), 100, lib::OrderStatus::NEW));
+        
+        Stopwatch sweep;
+        for (std::size_t i = 0; i < resting / fills_per_order; ++i)
+            book.add(lob::Order(2, "BENCH", ++order_id, !resting_buy, resting_buy ? lob::MIN_PRICE : lob::MAX_PRICE, aggressive_qty, lib::OrderStatus::NEW));
+        seconds += sweep.elapsed();
+    }
+    return seconds;
+}
+
+} // namespace
+
+void bench::level_lookup(std::size_t levels, lib::t_tick_index gap)
+{
+    lob::LevelStore store;
+    std::vector<lob::OrderBookEntry> entries(levels);
+    
+    for (std::size_t i = 0; i < levels; ++i)
+    {
+        const lib::t_tick_index tick = static_cast<lib::t_tick_index>(i) * gap;
+        store.at(tick)->orders.push_back(entries[i]);
+        store.set_occupied(tick);
+    }
+    
+    // linear walk over the empty levels in between, as askMin++ used to do
+    lib::t_tick_index sink = 0;
+    Stopwatch linear;
+    for (lib::t_tick_index tick = 0; tick < store.hi(); )
+    {
+        do
+        {
+            ++tick;
+        } while (tick <= store.hi() && store[tick].empty());
+        sink += tick;
+    }
+    report("level lookup, linear walk, gap " + std::to_string(gap), levels, linear.elapsed());
+    
+    Stopwatch bitmap;
+    for (lib::t_tick_index tick = 0; tick != lob::NO_LEVEL_ABOVE; )
+    {
+        tick = store.next_occupied(tick + 1);
+        sink += tick;
+    }
+    report("level lookup, occupancy bitmap, gap " + std::to_string(gap), levels, bitmap.elapsed());
+    
+    // unlink the entries before they are destroyed
+    for (std::size_t i = 0; i < levels; ++i)
+        store[static_cast<lib::t_tick_index>(i) * gap].orders.clear();
+    
+    if (sink == 42)
+        std::cout << std::endl;
+}
+
+void bench::wide_gap_sweep(std::size_t levels, lib::t_tick_index gap, std::size_t rounds)
+{
+    lob::OrderBook book("BENCH");
+    const lib::t_price base = 1000000;
+    double seconds = 0;
+    
+    {
+        MuteStdout mute;
+        for (std::size_t round = 0; round < rounds; ++round)
+        {
+            for (std::size_t i = 0; i < levels; ++i)
+                book.add(lob::Order(1, "BENCH", i + 1, false, base + static_cast<lib::t_price>(i) * gap, 100, lib::OrderStatus::NEW));
+            
+            Stopwatch sweep;
+            book.add(lob::Order(2, "BENCH", levels + 1, true, lob::MAX_PRICE, static_cast<lib::t_quantity>(levels) * 100, lib::OrderStatus::NEW));
+            seconds += sweep.elapsed();
+        }
+    }
+    report("wide gap sweep, gap " + std::to_string(gap) + " ticks, per level", levels * rounds, seconds);
+}
+
+void bench::fill_throughput(std::size_t resting, std::size_t fills_per_order, std::size_t rounds)
+{
+    lob::OrderBook book("BENCH", lib::TickSizeRule(), resting);
+    const double seconds = fill_rounds(book, resting, fills_per_order, rounds);
+    report("fill throughput, " + std::to_string(fills_per_order) + " fills per order, per fill", resting / fills_per_order * fills_per_order * rounds, seconds);
+}
+
+void bench::listener_overhead(std::size_t resting, std::size_t fills_per_order, std::size_t rounds)
+{
+    const std::size_t fills = resting / fills_per_order * fills_per_order * rounds;
+    {
+        lob::OrderBook book("BENCH", lib::TickSizeRule(), resting);
+        report("listener overhead, null listener, per fill", fills, fill_rounds(book, resting, fills_per_order, rounds));
+    }
+    {
+        // the events are packed into the encoder's batch and counted, nothing is written
+        std::size_t messages = 0;
+        notify::FeedEncoder encoder([&messages](const notify::FeedMessage*, std::size_t count) { messages += count; });
+        lob::BasicOrderBook<notify::RecordingListener> book("BENCH", lib::TickSizeRule(), resting);
+        book.listener().attach(&encoder, 0);
+        report("listener overhead, recording listener, per fill", fills, fill_rounds(book, resting, fills_per_order, rounds));
+        encoder.flush();
+        std::cout << "  " << messages << " messages, last sequence " << encoder.sequence() << std::endl;
+    }
+    {
+        const lib::FILE file_name = "listener_bench.bin";
+        std::remove(file_name.c_str());
+        notify::AsyncPublisher publisher(file_name);
+        {
+            notify::FeedEncoder encoder([&publisher](const notify::FeedMessage* messages, std::size_t count)
+            {
+                publisher.publish(messages, count * sizeof(notify::FeedMessage));
+            });
+            lob::BasicOrderBook<notify::RecordingListener> book("BENCH", lib::TickSizeRule(), resting);
+            book.listener().attach(&encoder, 0);
+            report("listener overhead, recording listener to the async writer, per fill", fills, fill_rounds(book, resting, fills_per_order, rounds));
+        }
+        publisher.stop();
+        nlohmann::json j;
+        publisher.stats().to_json(j);
+        std::cout << "  " << j << std::endl;
+        std::remove(file_name.c_str());
+    }
+}
+
+void bench::iceberg_throughput(std::size_t resting, std::size_t fills_per_order, std::size_t rounds)
+{
+    lob::OrderBook book("BENCH", lib::TickSizeRule(), resting);
+    const lib::t_price base = 1000000;
+    const lib::t_quantity aggressive_qty = static_cast<lib::t_quantity>(fills_per_order) * 100;
+    const std::size_t aggressive_orders = resting * 10 / fills_per_order; // every slice of every iceberg is filled
+    lib::t_orderid order_id = 0;
+    double seconds = 0;
+    
+    {
+        MuteStdout mute;
+        for (std::size_t round = 0; round < rounds; ++round)
+        {
+            const bool resting_buy = round % 2;
+            for (std::size_t i = 0; i < resting; ++i)
+                book.add(lob::Order(1, "BENCH", ++order_id, resting_buy, base + static_cast<lib::t_price>(i % 64), 100, 1000, lib::OrderStatus::NEW));
+            
+            Stopwatch sweep;
+            for (std::size_t i = 0; i < aggressive_orders; ++i)
+                book.add(lob::Order(2, "BENCH", ++order_id, !resting_buy, resting_buy ? lob::MIN_PRICE : lob::MAX_PRICE, aggressive_qty, lib::OrderStatus::NEW));
+            seconds += sweep.elapsed();
+        }
+    }
+    report("iceberg throughput, " + std::to_string(fills_per_order) + " fills per order, per fill", aggressive_orders * fills_per_order * rounds, seconds);
+}
+
+void bench::book_startup(std::size_t books, const lib::ArenaOptions& options)
+{
+    const std::string mode = std::string(options.huge_pages ? "huge pages" : "small pages")
+                           + (options.prefault ? ", prefaulted" : ", lazy")
+                           + (options.lock ? ", locked" : "");
+    std::vector<std::unique_ptr<lob::OrderBook>> order_books;
+    order_books.reserve(books);
+    
+    Stopwatch construct;
+    for (std::size_t i = 0; i < books; ++i)
+        order_books.emplace_back(new lob::OrderBook("BENCH" + std::to_string(i), lib::TickSizeRule(), MAX_LIVE_ORDERS, options));
+    report("book startup, " + mode + ", per book", books, construct.elapsed());
+    
+    Stopwatch first_order;
+    {
+        MuteStdout mute;
+        for (std::size_t i = 0; i < books; ++i)
+            order_books[i]->add(lob::Order(1, "BENCH", 1, true, 1000000, 100, lib::OrderStatus::NEW));
+    }
+    report("book startup, " + mode + ", first order", books, first_order.elapsed());
+}
+
+void bench::tick_lookup(std::size_t prices)
+{
+    // five bands, from 0.0001 below 1 to 0.1 above 1000
+    lib::TickSizeRule tsr;
+    tsr.FromJson(nlohmann::json::array({
+        {{"from_price", "0"}, {"to_price", "1"}, {"tick_size", 0.0001}},
+        {{"from_price", "1"}, {"to_price", "10"}, {"tick_size", 0.001}},
+        {{"from_price", "10"}, {"to_price", "100"}, {"tick_size", 0.01}},
+        {{"from_price", "100"}, {"to_price", "1000"}, {"tick_size", 0.05}},
+        {{"from_price", "1000"}, {"tick_size", 0.1}}}));
+    const std::vector<lib::Tick>& ticks = tsr.GetTicks();
+    
+    // prices spread evenly over the bands, about half of them on a tick
+    std::mt19937_64 generator(7);
+    std::vector<lib::t_price> unscaled;
+    for (std::size_t i = 0; i < prices; ++i)
+    {
+        const lib::Tick& tick = ticks[generator() % ticks.size()];
+        const lib::t_price top = std::min<lib::t_price>(tick.to_price.unscaled(), 100000000);
+        lib::t_price price = tick.from_price.unscaled() + generator() % (top - tick.from_price.unscaled());
+        if (generator() % 2)
+            price -= (price - tick.from_price.unscaled()) % tick.tick_units();
+        unscaled.push_back(std::max<lib::t_price>(price, 1));
+    }
+    
+    {
+        // the former check: a binary search over the ticks and a floating point division
+        std::size_t on_tick = 0;
+        Stopwatch watch;
+        for (lib::t_price price : unscaled)
+        {
+            const auto tick_itr = std::lower_bound(ticks.cbegin(), ticks.cend(), lib::Price4(price), [](const lib::Tick& lhs, lib::Price4 price){ return lhs.from_price < price;}) - 1;
+            const lib::t_tick num_ticks = 1.0 * price / 10000 / tick_itr->tick_size;
+            on_tick += std::abs(num_ticks - std::round(num_ticks)) <= 1e-6;
+        }
+        report("tick check, floating point", prices, watch.elapsed());
+        std::cout << "  " << on_tick << " on tick" << std::endl;
+    }
+    {
+        std::size_t on_tick = 0;
+        Stopwatch watch;
+        for (lib::t_price price : unscaled)
+            on_tick += tsr.is_on_tick(price);
+        report("tick check, compiled bands", prices, watch.elapsed());
+        std::cout << "  " << on_tick << " on tick" << std::endl;
+    }
+    {
+        // the former mapping: walk the ticks, dividing the width of every band below
+        lib::t_tick_index checksum = 0;
+        Stopwatch watch;
+        for (lib::t_price price : unscaled)
+        {
+            lib::t_tick_index ticks_below = 0;
+            for (const auto& tick : ticks)
+            {
+                if (price < tick.to_price.unscaled() || &tick == &ticks.back())
+                {
+                    checksum += ticks_below + (price - tick.from_price.unscaled()) / tick.tick_units();
+                    break;
+                }
+                ticks_below += (tick.to_price.unscaled() - tick.from_price.unscaled()) / tick.tick_units();
+            }
+        }
+        report("price to tick, band walk", prices, watch.elapsed());
+        std::cout << "  checksum " << checksum << std::endl;
+    }
+    {
+        lib::t_tick_index checksum = 0;
+        Stopwatch watch;
+        for (lib::t_price price : unscaled)
+            checksum += tsr.price_to_tick(price);
+        report("price to tick, compiled bands", prices, watch.elapsed());
+        std::cout << "  checksum " << checksum << std::endl;
+    }
+    {
+        lib::t_price checksum = 0;
+        Stopwatch watch;
+        for (lib::t_price price : unscaled)
+            checksum += tsr.tick_to_price(tsr.price_to_tick(price));
+        report("price to tick and back, compiled bands", prices, watch.elapsed());
+        std::cout << "  checksum " << checksum << std::endl;
+    }
+}
@@ -0,0 +1,711 @@
+//
+//  checks.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/14/22.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "order_index.h"
+#include "order_decoder.h"
+#include "wire.h"
+#include "book.h"
+#include "feed.h"
+#include "recording_listener.h"
+#include "notifier.h"
+#include "engine.h"
+#include "benchmark.h"
+
+using namespace bench;
+
+namespace
+{
+
+/// @brief A book event as the feed reports it, without its sequence number and symbol.
+struct Event
+{
+    notify::FeedMessageType type;
+    lib::t_orderid order_id;
+    lib::t_quantity qty;
+    lib::t_volume level_qty;
+};
+
+/// @brief A book whose listener records every event into a vector as it happens.
+struct RecordedBook
+{
+    std::vector<notify::FeedMessage> messages;
+    notify::FeedEncoder encoder;
+    lob::BasicOrderBook<notify::RecordingListener> book;
+
+    RecordedBook()
+        : encoder([this](const notify::FeedMessage* batch, std::size_t count) { messages.insert(messages.end(), batch, batch + count); }, 1),
+          book("CHECK", lib::TickSizeRule(), 1024)
+    {
+        book.listener().attach(&encoder, 0);
+    }
+
+    /// @brief are the recorded events these ones, in this order and numbered from 1?
+    bool recorded(std::initializer_list<Event> events) const
+    {
+        if (messages.size() != events.size())
+            return false;
+        std::size_t i = 0;
+        for (const Event& event : events)
+        {
+            const notify::FeedMessage& message = messages[i++];
+            if (message.sequence != i || message.type != event.type || message.order_id != event.order_id ||
+                message.quantity != event.qty || message.level_qty != event.level_qty)
+                return false;
+        }
+        return true;
+    }
+};
+
+/// @brief print the result of a check
+bool check(const std::string& name, bool ok)
+{
+    std::cout << "check " << name << ": " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok;
+}
+
+using notify::FeedMessageType;
+
+/// @brief an incoming order filled exactly by the first resting order trades once, with nothing after it
+bool exact_fill()
+{
+    RecordedBook recorded;
+    recorded.book.add(lob::Order(1, "CHECK", 1, false, 1000000, 100, lib::OrderStatus::NEW));
+    recorded.book.add(lob::Order(2, "CHECK", 2, false, 1000000, 100, lib::OrderStatus::NEW));
+    recorded.book.add(lob::Order(3, "CHECK", 3, true, 1000000, 100, lib::OrderStatus::NEW));
+
+    return check("exact fill trades once", recorded.recorded({
+        {FeedMessageType::ADD, 1, 100, 100},
+        {FeedMessageType::ADD, 2, 100, 200},
+        {FeedMessageType::TRADE, 1, 100, 100},
+        {FeedMessageType::DELETE, 1, 0, 100}}) && recorded.book.level(1000000).visible_qty == 100);
+}
+
+/// @brief a filled iceberg slice is shown again at the back of its level, behind the orders which were already there
+bool iceberg_replenish()
+{
+    RecordedBook recorded;
+    recorded.book.add(lob::Order(1, "CHECK", 1, false, 1000000, 100, 250, lib::OrderStatus::NEW));
+    recorded.book.add(lob::Order(2, "CHECK", 2, false, 1000000, 100, lib::OrderStatus::NEW));
+    recorded.book.add(lob::Order(3, "CHECK", 3, true, 1000000, 150, lib::OrderStatus::NEW));
+    recorded.book.add(lob::Order(4, "CHECK", 4, true, 1000000, 150, lib::OrderStatus::NEW));
+
+    const lob::DepthLevel level = recorded.book.level(1000000);
+    return check("iceberg replenishes at the back of its level", recorded.recorded({
+        {FeedMessageType::ADD, 1, 100, 100},
+        {FeedMessageType::ADD, 2, 100, 200},
+        {FeedMessageType::TRADE, 1, 100, 100},
+        {FeedMessageType::MODIFY, 1, 100, 200},
+        {FeedMessageType::TRADE, 2, 50, 150},
+        {FeedMessageType::TRADE, 2, 50, 100},
+        {FeedMessageType::DELETE, 2, 0, 100},
+        {FeedMessageType::TRADE, 1, 100, 0},
+        {FeedMessageType::MODIFY, 1, 50, 50}}) && level.visible_qty == 50 && level.order_count == 1);
+}
+
+/// @brief a price text parses exactly at the scale of 4 decimals and formats back with 6, as the request files carry it
+bool price_text()
+{
+    auto parses_to = [](const char* text, lib::t_price unscaled)
+    {
+        lib::Price4 price;
+        return lib::Price4::parse(text, price) && price.unscaled() == unscaled;
+    };
+    auto refused = [](const char* text)
+    {
+        lib::Price4 price;
+        return !lib::Price4::parse(text, price);
+    };
+
+    const bool parsed = parses_to("136.380000", 1363800) && parses_to("136.38", 1363800) && parses_to("12", 120000) &&
+                        parses_to(".5", 5000) && parses_to("-1.5", -15000) && parses_to("+0.0001", 1);
+    const bool refusals = refused("136.38001") && refused("0.00001") && refused("") && refused("-") && refused(".") &&
+                          refused("1.2.3") && refused("1e4") && refused("99999999999999999999");
+    const bool formatted = lib::Price4(1399600).to_str() == "139.960000" && lib::Price4(-15000).to_str() == "-1.500000" &&
+                           lib::Price4(1).to_str() == "0.000100" && lib::Price4(lib::t_price(0)).to_str() == "0.000000";
+    return check("price text parses and formats exactly", parsed && refusals && formatted);
+}
+
+/// @brief each kind of bad request line is decoded and validated into its own reject reason, without throwing
+bool decoder_rejects()
+{
+    lib::TickSizeRule tick_size_rule;
+    tick_size_rule.FromJson(nlohmann::json::parse(R"([{"from_price": "0", "to_price": "1", "tick_size": 0.0001}, {"from_price": "1", "tick_size": 0.01}])"));
+    lob::OrderDecoder decoder;
+    lob::OrderFields fields;
+    lob::Order order;
+    auto reason = [&](const std::string& line)
+    {
+        return decoder.decode(line.data(), line.data() + line.size(), fields) ? order.from_fields(fields, tick_size_rule, 100)
+                                                                              : lob::RejectReason::SYNTAX_ERROR;
+    };
+    // a valid limit order with one field replaced
+    auto limit = [](const std::string& field, const std::string& value)
+    {
+        nlohmann::json j = {{"time", 1}, {"type", "NEW"}, {"order_id", 1}, {"symbol", "AAPL"}, {"side", "BUY"},
+                            {"limit_price", "10.00"}, {"quantity", 100}};
+        if (value.empty())
+            j.erase(field);
+        else
+            j[field] = nlohmann::json::parse(value);
+        return j.dump();
+    };
+
+    using lob::RejectReason;
+    const bool ok =
+        reason(limit("quantity", "100")) == RejectReason::NONE &&
+        reason(R"({"time":2,"type":"CANCEL","order_id":1})") == RejectReason::NONE &&
+        reason(limit("order_type", "\"MARKET\"")) == RejectReason::NONE &&
+        reason("{\"time\":1,") == RejectReason::SYNTAX_ERROR &&
+        reason("not an order") == RejectReason::SYNTAX_ERROR &&
+        reason(limit("quantity", "")) == RejectReason::MISSING_FIELD &&
+        reason(limit("quantity", "\"100\"")) == RejectReason::MISSING_FIELD &&
+        reason(limit("symbol", "\"A_SYMBOL_TOO_LONG_TO_KEEP\"")) == RejectReason::MISSING_FIELD &&
+        reason(limit("time", "0")) == RejectReason::BAD_TIMESTAMP &&
+        reason(limit("order_id", "-1")) == RejectReason::BAD_ORDER_ID &&
+        reason(limit("type", "\"AMEND\"")) == RejectReason::BAD_TYPE &&
+        reason(limit("side", "\"UP\"")) == RejectReason::BAD_SIDE &&
+        reason(limit("quantity", "0")) == RejectReason::BAD_QUANTITY &&
+        reason(limit("quantity", "150")) == RejectReason::ODD_LOT &&
+        reason(limit("limit_price", "\"-1.00\"")) == RejectReason::BAD_PRICE &&
+        reason(limit("limit_price", "\"ten\"")) == RejectReason::BAD_PRICE &&
+        reason(limit("limit_price", "\"10.005\"")) == RejectReason::OFF_TICK &&
+        reason(R"({"time":1,"type":"NEW","order_id":1,"symbol":"AAPL","side":"BUY","order_type":"ICEBERG","limit_price":"10.00","display":100,"total":500,"tif":"IOC"})") == RejectReason::ICEBERG_IOC &&
+        reason(R"({"time":1,"type":"NEW","order_id":1,"symbol":"AAPL","side":"BUY","order_type":"ICEBERG","limit_price":"10.00","display":500,"total":100})") == RejectReason::BAD_DISPLAY;
+    return check("decoder rejects each bad line for its reason", ok);
+}
+
+/// @brief orders written to a binary order file read back field for field with the symbols they were written with,
+///        and the reader's checks accept them, while a message with a field broken is rejected for its reason
+bool wire_round_trip()
+{
+    lib::TickSizeRule tick_size_rule;
+    tick_size_rule.FromJson(nlohmann::json::parse(R"([{"from_price": "0", "to_price": "1", "tick_size": 0.0001}, {"from_price": "1", "tick_size": 0.01}])"));
+    lob::OrderDecoder decoder;
+    lob::OrderFields fields;
+    std::vector<lob::Order> orders;
+    for (const char* line : {R"({"time":1,"type":"NEW","order_id":1,"symbol":"AAPL","side":"BUY","limit_price":"10.25","quantity":300})",
+                             R"({"time":2,"type":"NEW","order_id":2,"symbol":"TSLA","side":"SELL","order_type":"ICEBERG","limit_price":"0.5001","display":100,"total":500,"tif":"GTC"})",
+                             R"({"time":3,"type":"NEW","order_id":3,"symbol":"AAPL","side":"SELL","order_type":"MARKET","quantity":200})",
+                             R"({"time":4,"type":"NEW","order_id":4,"symbol":"TSLA","side":"BUY","limit_price":"12.00","quantity":100,"tif":"IOC"})",
+                             R"({"time":5,"type":"CANCEL","order_id":1})"})
+    {
+        orders.emplace_back();
+        decoder.decode(line, line + std::strlen(line), fields);
+        if (orders.back().from_fields(fields, tick_size_rule, 100) != lob::RejectReason::NONE)
+            return check("binary order file round trip", false);
+    }
+
+    const lib::FILE file_name = (std::filesystem::temp_directory_path() / "exchange_checks.wire").string();
+    {
+        lob::WireWriter writer(file_name);
+        for (const lob::Order& order : orders)
+            writer.write(order);
+        writer.close();
+    }
+
+    bool ok = true;
+    {
+        const lob::WireReader reader(file_name);
+        ok &= reader.size() == orders.size() && reader.symbol_count() == 2 && reader.symbol(0) == "AAPL" && reader.symbol(1) == "TSLA";
+        for (std::size_t i = 0; i < orders.size() && ok; ++i)
+        {
+            const lob::Order& order = orders[i];
+            const lob::WireOrder& message = reader[i];
+            ok &= message.check(tick_size_rule, 100, reader.symbol_count()) == lob::RejectReason::NONE &&
+                  message.orderid() == order.orderid() && message.time == order.timestamp() && message.status_code() == order.status();
+            if (order.status() == lib::OrderStatus::CANCEL)
+                continue;
+            ok &= reader.symbol(message.symbol_id) == order.symbol() && message.order_type() == order.order_type() &&
+                  message.is_buy() == order.is_buy() && message.limit_price() == order.price() && message.order_qty() == order.order_qty() &&
+                  message.open_qty() == order.open_qty() && message.immediate_or_cancel() == order.immediate_or_cancel() &&
+                  message.good_till_cancel() == order.good_till_cancel();
+        }
+
+        // the iceberg order, broken one field at a time
+        auto reason = [&](auto&& breaks)
+        {
+            lob::WireOrder message = reader[1];
+            breaks(message);
+            return message.check(tick_size_rule, 100, reader.symbol_count());
+        };
+        using lob::RejectReason;
+        ok &= reason([](lob::WireOrder& m) { m.order_id = 0; }) == RejectReason::BAD_ORDER_ID &&
+              reason([](lob::WireOrder& m) { m.time = 0; }) == RejectReason::BAD_TIMESTAMP &&
+              reason([](lob::WireOrder& m) { m.status = static_cast<std::uint8_t>(lib::OrderStatus::ACCEPT); }) == RejectReason::BAD_TYPE &&
+              reason([](lob::WireOrder& m) { m.symbol_id = 2; }) == RejectReason::BAD_SYMBOL_ID &&
+              reason([](lob::WireOrder& m) { m.side = 2; }) == RejectReason::BAD_SIDE &&
+              reason([](lob::WireOrder& m) { m.type = 0xff; }) == RejectReason::BAD_TYPE &&
+              reason([](lob::WireOrder& m) { m.quantity = 0; }) == RejectReason::BAD_QUANTITY &&
+              reason([](lob::WireOrder& m) { m.display = 150; }) == RejectReason::ODD_LOT &&
+              reason([](lob::WireOrder& m) { m.display = 600; }) == RejectReason::BAD_DISPLAY &&
+              reason([](lob::WireOrder& m) { m.type = static_cast<std::uint8_t>(lib::OrderType::LIMIT); }) == RejectReason::BAD_QUANTITY &&
+              reason([](lob::WireOrder& m) { m.price = 0; }) == RejectReason::BAD_PRICE &&
+              reason([](lob::WireOrder& m) { m.price = 50015; }) == RejectReason::OFF_TICK &&
+              reason([](lob::WireOrder& m) { m.tif = static_cast<std::uint8_t>(lib::TimeInForce::IOC); }) == RejectReason::ICEBERG_IOC;
+    }
+    std::remove(file_name.c_str());
+    return check("binary order file round trip", ok);
+}
+
+/// @brief the order index agrees with a hash map over a random mix of inserts, overwrites, erases and reused ids,
+///        from ids in a narrow range so probe runs collide and erases shift their followers back, across rehashes
+bool order_index()
+{
+    lob::OrderIndex index;
+    std::unordered_map<lib::t_orderid, std::uint32_t> expected;
+    std::mt19937_64 generator(7);
+    std::uniform_int_distribution<lib::t_orderid> ids(1, 4096);
+
+    bool ok = true;
+    for (std::uint32_t op = 0; op < 200000 && ok; ++op)
+    {
+        const lib::t_orderid order_id = ids(generator);
+        if (generator() % 3 == 0)
+        {
+            ok &= index.erase(order_id) == (expected.erase(order_id) != 0);
+        }
+        else
+        {
+            index.insert(order_id, op);
+            expected[order_id] = op;
+        }
+        if (op % 1000 == 0)
+        {
+            for (lib::t_orderid id = 1; id <= 4096; ++id)
+            {
+                const auto it = expected.find(id);
+                ok &= index.find(id) == (it == expected.end() ? lob::OrderIndex::npos : it->second);
+            }
+        }
+    }
+    return check("order index matches a hash map", ok && index.size() == expected.size());
+}
+
+/// @brief the top of book cache of each side holds the best MAX_DEPTH_LEVELS levels a scan of the book finds, after
+///        every add, fill and cancel of a random flow crowded into a few ticks, so most of them land inside the top 10
+bool depth_cache()
+{
+    lob::OrderBook book("CHECK", lib::TickSizeRule(), 4096);
+    std::mt19937_64 generator(11);
+    const lib::t_price mid = 1000000;
+    const lib::t_price tick = 100;
+    const int ticks = 16;
+
+    // the non-empty levels of a side from its best price on, as many as the cache holds at most
+    auto scan = [&](bool is_bid)
+    {
+        std::vector<lob::DepthLevel> levels;
+        for (lib::t_price price = is_bid ? book.best_bid() : book.best_ask();
+             price >= mid - ticks * tick && price <= mid + ticks * tick && levels.size() < MAX_DEPTH_LEVELS;
+             price += is_bid ? -tick : tick)
+        {
+            const lob::DepthLevel level = book.level(price);
+            if (level.order_count != 0)
+                levels.push_back(level);
+        }
+        return levels;
+    };
+    auto same = [](const lob::DepthLevel* cached, std::size_t count, const std::vector<lob::DepthLevel>& levels)
+    {
+        if (count != levels.size())
+            return false;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (cached[i].price != levels[i].price || cached[i].visible_qty != levels[i].visible_qty ||
+                cached[i].hidden_qty != levels[i].hidden_qty || cached[i].order_count != levels[i].order_count)
+                return false;
+        }
+        return true;
+    };
+
+    bool ok = true;
+    lib::t_orderid order_id = 0;
+    for (int op = 0; op < 20000 && ok; ++op)
+    {
+        const std::uint64_t draw = generator();
+        if (draw % 4 == 0 && order_id != 0)
+        {
+            book.cancel(1 + generator() % order_id);
+        }
+        else
+        {
+            // buys a little below the middle and sells a little above, so that some of them cross
+            const bool is_buy = draw % 2;
+            const lib::t_price price = mid + (is_buy ? -1 : 1) * static_cast<lib::t_price>(generator() % ticks) * tick
+                                     + (is_buy ? 2 : -2) * tick;
+            const lib::t_quantity qty = 100 * static_cast<lib::t_quantity>(1 + generator() % 5);
+            if (draw % 7 == 0)
+                book.add(lob::Order(1, "CHECK", ++order_id, is_buy, price, 100, 2 * qty, lib::OrderStatus::NEW));
+            else
+                book.add(lob::Order(1, "CHECK", ++order_id, is_buy, price, qty, lib::OrderStatus::NEW));
+        }
+        const lob::DepthSnapshot depth = book.depth();
+        ok &= same(depth.bids, depth.bid_count, scan(true)) && same(depth.asks, depth.ask_count, scan(false));
+    }
+    return check("depth cache holds the best levels", ok);
+}
+
+/// @brief levels the capped window can't reach take the preallocated outlier slots in price order, a far price
+///        past the last slot is refused, and an emptied outlier gives its slot back
+bool outlier_levels()
+{
+    lob::LevelStore store;
+    lob::OrderBookEntry entry;
+    store.at(0)->orders.push_back(entry);
+    store.set_occupied(0);
+
+    // every other far tick, from the top down, so each one is inserted in front of the others
+    const lib::t_tick_index far = 2 * LEVEL_WINDOW_MAX;
+    bool ok = true;
+    for (lib::t_tick_index k = LEVEL_OUTLIER_MAX; k-- > 0; )
+        ok &= store.at(far + 2 * k) != nullptr;
+    ok &= store.at(far + 1) == nullptr && store.outlier_count() == LEVEL_OUTLIER_MAX && !store.contains(far + 1);
+
+    lib::t_tick_index tick = 0;
+    for (lib::t_tick_index k = 0; k < LEVEL_OUTLIER_MAX; ++k)
+        ok &= (tick = store.next_occupied(tick + 1)) == far + 2 * k;
+    ok &= store.prev_occupied(far + 3) == far + 2 && store.next_occupied(tick + 1) == lob::NO_LEVEL_ABOVE;
+
+    store.set_empty(far + 2);
+    ok &= store.at(far + 1) != nullptr && store.next_occupied(far + 1) == far + 1;
+
+    store[0].orders.clear();
+    return check("outlier levels are bounded and ordered", ok);
+}
+
+/// @brief an order id still resting in one symbol's book is refused for another symbol, so its cancel still
+///        finds the order; once the cancel lets the order go, the id may be used again in any symbol
+bool reused_order_id()
+{
+    eng::MatchingEngine engine;
+    lob::Order first(1, "FIRST", 7, false, 1000000, 100, lib::OrderStatus::NEW);
+    lob::Order second(2, "SECOND", 7, false, 1000000, 100, lib::OrderStatus::NEW);
+    lob::Order cancel(3, 7);
+    lob::Order again(4, "SECOND", 7, false, 1000000, 100, lib::OrderStatus::NEW);
+
+    engine.submit(first);
+    const bool refused = !engine.submit(second) &&
+                         engine.reject_stats().counts[static_cast<std::size_t>(lob::RejectReason::DUPLICATE_ORDER_ID)] == 1;
+    const bool cancelled = engine.submit(cancel) && !engine.book(first.symbol_id()).contains(7) && engine.routed_orders() == 0;
+    engine.submit(again);
+    return check("reused order id is refused until its order leaves the book",
+                 refused && cancelled && engine.book(again.symbol_id()).contains(7) && engine.routed_orders() == 1);
+}
+
+/// @brief the books of the engine record their events into the feed while they retire the orders they let go
+bool engine_feed()
+{
+    std::vector<notify::FeedMessage> messages;
+    notify::FeedEncoder encoder([&messages](const notify::FeedMessage* batch, std::size_t count) { messages.insert(messages.end(), batch, batch + count); }, 1);
+    eng::MatchingEngine engine;
+    engine.set_feed(&encoder);
+
+    lob::Order sell(1, "FEED", 1, false, 1000000, 100, lib::OrderStatus::NEW);
+    lob::Order buy(2, "FEED", 2, true, 1000000, 100, lib::OrderStatus::NEW);
+    engine.submit(sell);
+    engine.submit(buy);
+    return check("engine books feed the market data",
+                 messages.size() == 3 && messages[0].type == FeedMessageType::ADD && messages[1].type == FeedMessageType::TRADE &&
+                 messages[2].type == FeedMessageType::DELETE && messages[2].symbol_id == sell.symbol_id() && engine.routed_orders() == 0);
+}
+
+/// @brief write a request file of random orders over a few symbols, most of them on the first so it runs hot, priced a few
+///        cents around 100 so they trade often, with cancels of earlier orders; seeded, so every run writes the same file
+lib::FILE skewed_requests(std::size_t count)
+{
+    const lib::FILE file_name = (std::filesystem::temp_directory_path() / "exchange_checks.json").string();
+    std::ofstream out(file_name, std::ios::out | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cout << "FAILED TO OPEN " << file_name << ".\n";
+        throw std::exception();
+    }
+
+    const std::vector<lib::t_symbol> symbols = {"HOT", "WARM", "COOL", "COLD"};
+    std::mt19937_64 generator(11);
+    std::discrete_distribution<std::size_t> symbol(std::initializer_list<double>{14, 3, 2, 1});
+    std::vector<lib::t_orderid> order_ids;
+    for (std::size_t i = 1; i <= count; ++i)
+    {
+        lob::Order order;
+        if (!order_ids.empty() && generator() % 10 < 3)
+        {
+            const std::size_t k = generator() % order_ids.size();
+            order = lob::Order(static_cast<lib::t_time>(i), order_ids[k]);
+            order_ids[k] = order_ids.back();
+            order_ids.pop_back();
+        }
+        else
+        {
+            order_ids.push_back(i);
+            const lib::t_price price = 1000000 + (static_cast<lib::t_price>(generator() % 9) - 4) * 100;
+            order = lob::Order(static_cast<lib::t_time>(i), symbols[symbol(generator)], i, generator() % 2 == 0, price,
+                               static_cast<lib::t_quantity>(1 + generator() % 5) * 100, lib::OrderStatus::NEW);
+        }
+        nlohmann::json j;
+        order.to_json(j);
+        out << j << '\n';
+    }
+    return file_name;
+}
+
+/// @brief match a request file on the calling thread, reporting each request as a pipeline shard would
+/// @return the reports of each symbol id, in file order
+std::vector<std::vector<eng::ExecutionReport>> sequential_reports(eng::MatchingEngine& engine, const lib::FILE& file_name)
+{
+    std::vector<std::vector<eng::ExecutionReport>> reports;
+    engine.parse_requests(file_name, [&](lob::Order& order)
+    {
+        const lib::t_symbol_id symbol_id = engine.route(order);
+        if (symbol_id == lib::NO_SYMBOL_ID)
+            return;
+        eng::Book& book = engine.book(symbol_id);
+        eng::ExecutionReport report;
+        report.symbol_id = symbol_id;
+        report.order_id = order.orderid();
+        report.cancel = order.status() == lib::OrderStatus::CANCEL;
+        report.filled = eng::execute(book, order);
+        report.resting = book.contains(order.orderid());
+        report.best_bid = book.best_bid();
+        report.best_ask = book.best_ask();
+        if (reports.size() <= symbol_id)
+            reports.resize(symbol_id + 1);
+        reports[symbol_id].push_back(report);
+    });
+    return reports;
+}
+
+/// @brief are the reports of each symbol the expected ones, in the same order?
+///        A cancel which removed nothing is left out: a matching thread retires the orders its book lets go a little
+///        after they leave, so it may still be handed the cancel of an order which just traded away, where a single
+///        thread rejects that cancel before it reaches the book.
+bool same_reports(const std::vector<std::vector<eng::ExecutionReport>>& reports, const std::vector<std::vector<eng::ExecutionReport>>& expected)
+{
+    if (reports.size() != expected.size())
+        return false;
+    auto changed = [](const std::vector<eng::ExecutionReport>& all)
+    {
+        std::vector<eng::ExecutionReport> kept;
+        for (const eng::ExecutionReport& report : all)
+        {
+            if (!report.cancel || report.filled)
+                kept.push_back(report);
+        }
+        return kept;
+    };
+    for (std::size_t symbol_id = 0; symbol_id < expected.size(); ++symbol_id)
+    {
+        const std::vector<eng::ExecutionReport> left = changed(reports[symbol_id]);
+        const std::vector<eng::ExecutionReport> right = changed(expected[symbol_id]);
+        if (left.size() != right.size())
+            return false;
+        for (std::size_t i = 0; i < right.size(); ++i)
+        {
+            const eng::ExecutionReport& a = left[i];
+            const eng::ExecutionReport& b = right[i];
+            if (a.symbol_id != b.symbol_id || a.order_id != b.order_id || a.cancel != b.cancel || a.filled != b.filled ||
+                a.resting != b.resting || a.best_bid != b.best_bid || a.best_ask != b.best_ask)
+                return false;
+        }
+    }
+    return true;
+}
+
+/// @brief a pipeline reports the requests of each symbol in file order, each with the outcome and top of book
+///        a single thread matching the whole file gives it, however the symbols are spread over the shards;
+///        with a rebalance threshold the hot symbol's load moves symbols between shards while the file runs
+bool pipeline_report_order(double rebalance_threshold)
+{
+    const lib::FILE file_name = skewed_requests(20000);
+    eng::MatchingEngine sequential;
+    const std::vector<std::vector<eng::ExecutionReport>> expected = sequential_reports(sequential, file_name);
+
+    std::vector<std::vector<eng::ExecutionReport>> reports;
+    eng::MatchingEngine engine;
+    eng::PipelineConfig config;
+    config.shards = 3;
+    config.ring_capacity = 64;
+    config.rebalance_threshold = rebalance_threshold;
+    config.rebalance_interval = 512;
+    config.on_report = [&reports](const eng::ExecutionReport& report)
+    {
+        if (reports.size() <= report.symbol_id)
+            reports.resize(report.symbol_id + 1);
+        reports[report.symbol_id].push_back(report);
+    };
+    eng::PipelineStats stats;
+    {
+        MuteStdout mute;
+        stats = engine.match_orders(file_name, config);
+    }
+    std::remove(file_name.c_str());
+    if (rebalance_threshold == 0)
+        return check("pipeline reports each symbol in file order", same_reports(reports, expected));
+    return check("rebalanced pipeline reports each symbol in file order", same_reports(reports, expected) && !stats.migrations.empty());
+}
+
+/// @brief a work-stealing pool matches the orders of each symbol in file order, in small batches so the symbol queues
+///        move between workers: every book ends with the orders and top of book a single thread leaves, after as many fills
+bool scheduler_symbol_order()
+{
+    const lib::FILE file_name = skewed_requests(20000);
+    eng::MatchingEngine sequential;
+    const std::vector<std::vector<eng::ExecutionReport>> expected = sequential_reports(sequential, file_name);
+
+    eng::MatchingEngine engine;
+    eng::SchedulerConfig config;
+    config.workers = 4;
+    config.batch_size = 4;
+    config.queue_capacity = 64;
+    eng::SchedulerStats stats;
+    {
+        MuteStdout mute;
+        stats = engine.match_orders(file_name, config);
+    }
+    std::remove(file_name.c_str());
+
+    std::size_t fills = 0;
+    bool ok = engine.symbols().size() == expected.size();
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < expected.size() && ok; ++symbol_id)
+    {
+        eng::Book& book = engine.book(symbol_id);
+        eng::Book& expected_book = sequential.book(symbol_id);
+        ok &= book.best_bid() == expected_book.best_bid() && book.best_ask() == expected_book.best_ask();
+        for (const eng::ExecutionReport& report : expected[symbol_id])
+        {
+            fills += !report.cancel && report.filled;
+            ok &= book.contains(report.order_id) == expected_book.contains(report.order_id);
+        }
+    }
+    return check("work stealing matches each symbol in file order", ok && stats.fills == fills);
+}
+
+/// @brief the json lines a notifier publishes are the text of its json documents
+bool notifier_lines()
+{
+    notify::Notifier notifier;
+    notifier.notify_trade(1314000, 100);
+    notifier.update_bid(notify::CallbackAction::ADD, 1313900, 200);
+    notifier.update_bid(notify::CallbackAction::MODIFY, 1313800, 300);
+    notifier.update_ask(notify::CallbackAction::DELETE, 1314100, 0);
+    notifier.notify_update();
+    notifier.notify_update();
+
+    bool same = notifier.get_messages().size() == 3;
+    std::string line;
+    for (const notify::Callback& message : notifier.get_messages())
+    {
+        line.clear();
+        notifier.append_json(line, message);
+        same &= line == notifier.to_json(message).dump();
+    }
+    return check("notifier lines match its json", same);
+}
+
+#ifdef EXCHANGE_CHECKS
+/// @brief once its buffers and its line hold a batch, a notifier records, renders and publishes the next batches
+///        without touching the heap; events past the reserved buffers are dropped and counted instead of growing them
+bool notifier_allocations(std::size_t rounds)
+{
+    notify::Notifier notifier("/dev/null");
+    auto batch = [&notifier](std::size_t r)
+    {
+        const lib::t_price price = 1000000 + static_cast<lib::t_price>(r % 100) * 100;
+        for (std::size_t k = 0; k < 8; ++k)
+        {
+            notifier.notify_trade(price, 100);
+            notifier.update_ask(notify::CallbackAction::MODIFY, price, 700 - 100 * static_cast<lib::t_quantity>(k));
+        }
+        notifier.update_bid(notify::CallbackAction::ADD, price - 100, 200);
+        notifier.notify_update();
+        notifier.publish();
+        notifier.clear();
+    };
+
+    batch(0);
+    const std::size_t before = allocation_count();
+    for (std::size_t r = 0; r < rounds; ++r)
+        batch(r);
+    for (std::size_t k = 0; k <= MAX_MESSAGE_NUM; ++k)
+        notifier.notify_trade(1000000, 100);
+    for (std::size_t k = 0; k <= MAX_LEVEL_CHANGE_NUM; ++k)
+        notifier.update_bid(notify::CallbackAction::ADD, 1000000, 100);
+    const std::size_t allocated = allocation_count() - before;
+
+    std::cout << "notifier: " << allocated << " heap allocations over " << rounds << " batches, "
+              << notifier.dropped() << " events dropped" << std::endl;
+    return check("notifier doesn't allocate", allocated == 0 && notifier.dropped() == 2 && notifier.publisher_stats().published_records != 0);
+}
+
+/// @brief once its price levels exist, matching an order through the book, its listener and the feed encoder
+///        doesn't touch the heap: a sweep of eight asks which trades, deletes and rests the remainder, then its cancel
+bool event_path_allocations(std::size_t rounds)
+{
+    std::size_t encoded = 0;
+    notify::FeedEncoder encoder([&encoded](const notify::FeedMessage*, std::size_t count) { encoded += count; });
+    lob::BasicOrderBook<notify::RecordingListener> book("CHECK", lib::TickSizeRule(), 1024);
+    book.listener().attach(&encoder, 0);
+
+    lib::t_orderid order_id = 0;
+    auto round = [&](std::size_t r)
+    {
+        const lib::t_price price = 1000000 + static_cast<lib::t_price>(r % 100) * 100;
+        for (std::size_t k = 0; k < 8; ++k)
+            book.add(lob::Order(1, "CHECK", ++order_id, false, price, 100, lib::OrderStatus::NEW));
+        book.add(lob::Order(1, "CHECK", ++order_id, true, price, 1000, lib::OrderStatus::NEW));
+        book.cancel(order_id);
+    };
+
+    // the first pass over the prices allocates their levels
+    for (std::size_t r = 0; r < 100; ++r)
+        round(r);
+    const std::size_t before = allocation_count();
+    for (std::size_t r = 0; r < rounds; ++r)
+        round(r);
+    const std::size_t allocated = allocation_count() - before;
+
+    std::cout << "event path: " << allocated << " heap allocations over " << rounds << " rounds, "
+              << encoded << " messages encoded" << std::endl;
+    return check("event path doesn't allocate", allocated == 0 && encoded != 0);
+}
+#endif
+
+} // namespace
+
+bool bench::run_checks()
+{
+    bool ok = true;
+    ok &= exact_fill();
+    ok &= iceberg_replenish();
+    ok &= price_text();
+    ok &= order_index();
+    ok &= decoder_rejects();
+    ok &= wire_round_trip();
+    ok &= depth_cache();
+    ok &= outlier_levels();
+    ok &= reused_order_id();
+    ok &= engine_feed();
+    ok &= pipeline_report_order(0);
+    ok &= pipeline_report_order(1.05);
+    ok &= scheduler_symbol_order();
+    ok &= notifier_lines();
+#ifdef EXCHANGE_CHECKS
+    ok &= event_path_allocations(100000);
+    ok &= notifier_allocations(100000);
+#endif
+    return ok;
+}
@@ -0,0 +1,81 @@
+//
+//  engine_bench.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/3/22.
+//
+
+#include "engine.h"
+#include "order_generator.h"
+#include "benchmark.h"
+
+using namespace bench;
+
+void bench::pipeline_replay(const lib::FILE& order_request_file_name, const lib::FILE& config_file_name, std::size_t max_shards, lib::WaitStrategy wait_strategy)
+{
+    for (std::size_t shards = 1; shards <= max_shards; ++shards)
+    {
+        eng::MatchingEngine engine(config_file_name);
+        eng::PipelineConfig config;
+        config.shards = shards;
+        config.wait_strategy = wait_strategy;
+        
+        eng::PipelineStats stats;
+        {
+            MuteStdout mute;
+            stats = engine.match_orders(order_request_file_name, config);
+        }
+        report("pipeline replay, " + std::to_string(shards) + " shards, per request", stats.requests, stats.seconds);
+    }
+}
+
+void bench::zipf_replay(std::size_t symbols, std::size_t orders, double exponent, std::size_t threads, const lib::FILE& config_file_name)
+{
+    const lib::FILE file_name = "orders_zipf.json";
+    {
+        eng::MatchingEngine engine(config_file_name);
+        std::vector<lib::t_symbol> names;
+        for (std::size_t i = 0; i < symbols; ++i)
+            names.push_back("SYM" + std::to_string(i));
+        lob::OrderGenerator generator(names, exponent, file_name);
+        generator.run(engine.tick_size_rule(), engine.lot_size(), orders);
+    }
+    
+    const std::string mix = std::to_string(symbols) + " symbols, zipf " + std::to_string(exponent) + ", " + std::to_string(threads) + " threads";
+    {
+        eng::MatchingEngine engine(config_file_name);
+        eng::PipelineConfig config;
+        config.shards = threads;
+        eng::PipelineStats stats;
+        {
+            MuteStdout mute;
+            stats = engine.match_orders(file_name, config);
+        }
+        report("zipf replay, static shards, " + mix + ", per request", stats.requests, stats.seconds);
+    }
+    {
+        eng::MatchingEngine engine(config_file_name);
+        eng::PipelineConfig config;
+        config.shards = threads;
+        config.rebalance_threshold = 1.2;
+        eng::PipelineStats stats;
+        {
+            MuteStdout mute;
+            stats = engine.match_orders(file_name, config);
+        }
+        report("zipf replay, rebalanced shards, " + mix + ", per request", stats.requests, stats.seconds);
+        std::cout << "  " << stats.migrations.size() << " migrations" << std::endl;
+    }
+    {
+        eng::MatchingEngine engine(config_file_name);
+        eng::SchedulerConfig config;
+        config.workers = threads;
+        eng::SchedulerStats stats;
+        {
+            MuteStdout mute;
+            stats = engine.match_orders(file_name, config);
+        }
+        report("zipf replay, work stealing, " + mix + ", per request", stats.requests, stats.seconds);
+        std::cout << "  " << stats.steals << " steals over " << stats.batches << " batches" << std::endl;
+    }
+}
@@ -0,0 +1,126 @@
+//
+//  feed_bench.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/10/22.
+//
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "message.h"
+#include "notifier.h"
+#include "feed.h"
+#include "async_publisher.h"
+#include "benchmark.h"
+
+using namespace bench;
+
+void bench::feed_throughput(std::size_t events)
+{
+    // a mix of book events at random prices around 100.00
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<lib::t_price> price(990000, 1010000);
+    std::uniform_int_distribution<lib::t_quantity> quantity(1, 100);
+    std::vector<lib::t_price> prices(events);
+    std::vector<lib::t_quantity> quantities(events);
+    for (std::size_t i = 0; i < events; ++i)
+    {
+        prices[i] = price(gen) / 100 * 100;
+        quantities[i] = quantity(gen) * 100;
+    }
+    
+    {
+        // the json notifier: a Callback per event, rendered and dumped on the matching thread
+        notify::Notifier notifier;
+        std::size_t bytes = 0;
+        Stopwatch watch;
+        for (std::size_t i = 0; i < events; ++i)
+        {
+            if (i % 4 == 3)
+                bytes += notifier.to_json(notifier.notify_trade(prices[i], quantities[i])).dump().size();
+            else
+                bytes += notifier.to_json(notifier.update_bid(notify::CallbackAction::ADD, prices[i], quantities[i])).dump().size();
+            if (i % MAX_MESSAGE_NUM == MAX_MESSAGE_NUM - 1)
+                notifier.clear();
+        }
+        report("feed, json notifier, per event", events, watch.elapsed());
+        std::cout << "  " << bytes / events << " bytes per event" << std::endl;
+    }
+    {
+        // the binary feed: a 48 byte message per event, batches handed to a sink which only counts them
+        std::size_t bytes = 0;
+        Stopwatch watch;
+        {
+            notify::FeedEncoder encoder([&bytes](const notify::FeedMessage*, std::size_t count) { bytes += count * sizeof(notify::FeedMessage); });
+            for (std::size_t i = 0; i < events; ++i)
+            {
+                if (i % 4 == 3)
+                    encoder.trade(0, i, true, prices[i], quantities[i], quantities[i]);
+                else
+                    encoder.add(0, i, true, prices[i], quantities[i], quantities[i]);
+            }
+        }
+        report("feed, binary encoder, per event", events, watch.elapsed());
+        std::cout << "  " << bytes / events << " bytes per event" << std::endl;
+    }
+    {
+        // the binary feed written to a file
+        const lib::FILE file_name = "feed_bench.bin";
+        std::remove(file_name.c_str());
+        Stopwatch watch;
+        {
+            notify::FeedWriter writer(file_name);
+            notify::FeedEncoder encoder([&writer](const notify::FeedMessage* messages, std::size_t count) { writer.write(messages, count); });
+            for (std::size_t i = 0; i < events; ++i)
+                encoder.add(0, i, true, prices[i], quantities[i], quantities[i]);
+        }
+        report("feed, binary encoder to a file, per event", events, watch.elapsed());
+        std::remove(file_name.c_str());
+    }
+}
+
+void bench::publisher_throughput(std::size_t events, std::size_t batch_messages)
+{
+    const lib::FILE file_name = "publisher_bench.bin";
+    auto run = [&](const std::string& name, const notify::FeedEncoder::Sink& sink)
+    {
+        Stopwatch watch;
+        {
+            notify::FeedEncoder encoder(sink, batch_messages);
+            for (std::size_t i = 0; i < events; ++i)
+                encoder.add(0, i, i % 2 == 0, 1000000 + static_cast<lib::t_price>(i % 100) * 100, 100, 100);
+        }
+        report(name + ", per event", events, watch.elapsed());
+    };
+    
+    {
+        // the former Notifier::publish: the file is opened and rewritten on the matching thread for every batch
+        std::remove(file_name.c_str());
+        run("publish, reopened file per batch", [&](const notify::FeedMessage* messages, std::size_t count)
+        {
+            std::ofstream file(file_name, std::ios::out | std::ios::binary | std::ios::app);
+            file.write(reinterpret_cast<const char*>(messages), count * sizeof(notify::FeedMessage));
+        });
+    }
+    {
+        std::remove(file_name.c_str());
+        notify::FeedWriter writer(file_name);
+        run("publish, stream on the matching thread", [&](const notify::FeedMessage* messages, std::size_t count) { writer.write(messages, count); });
+    }
+    for (bool drop : {false, true})
+    {
+        std::remove(file_name.c_str());
+        notify::PublisherConfig config;
+        config.drop_when_full = drop;
+        notify::AsyncPublisher publisher(file_name, config);
+        run(drop ? "publish, async writer, dropping when full" : "publish, async writer, waiting when full",
+            [&](const notify::FeedMessage* messages, std::size_t count) { publisher.publish(messages, count * sizeof(notify::FeedMessage)); });
+        publisher.stop();
+        nlohmann::json j;
+        publisher.stats().to_json(j);
+        std::cout << "  " << j << std::endl;
+    }
+    std::remove(file_name.c_str());
+}
@@ -0,0 +1,270 @@
+//
+//  parser_bench.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/5/22.
+//
+
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "engine.h"
+#include "parser.h"
+#include "order_decoder.h"
+#include "wire.h"
+#include "price4.h"
+#include "benchmark.h"
+
+using namespace bench;
+
+void bench::parse_throughput(const lib::FILE& order_request_file_name, const lib::FILE& config_file_name, std::size_t max_threads)
+{
+    eng::MatchingEngine engine(config_file_name);
+    struct stat status;
+    const double megabytes = ::stat(order_request_file_name.c_str(), &status) == 0 ? status.st_size / 1e6 : 0;
+    
+    // threads == 0 runs the getline stream, the others the mapped file cut into chunks
+    for (std::size_t threads = 0; threads <= max_threads; ++threads)
+    {
+        lob::OrderParser parser;
+        lib::t_quantity checksum = 0;
+        std::size_t orders = 0;
+        Stopwatch watch;
+        {
+            MuteStdout mute;
+            auto handler = [&](lob::Order& order) { checksum += order.order_qty(); };
+            if (threads == 0)
+                orders = parser.for_each(order_request_file_name, engine.tick_size_rule(), engine.lot_size(), handler);
+            else
+                orders = parser.for_each(order_request_file_name, engine.tick_size_rule(), engine.lot_size(), threads, handler);
+        }
+        const double seconds = watch.elapsed();
+        
+        const std::string name = threads == 0 ? std::string("parse, stream") : "parse, mapped chunks, " + std::to_string(threads) + " threads";
+        report(name + ", per order", orders, seconds);
+        std::cout << "  " << megabytes / seconds << " MB/s, checksum " << checksum << std::endl;
+    }
+}
+
+void bench::decode_throughput(const lib::FILE& order_request_file_name, const lib::FILE& config_file_name, std::size_t copies)
+{
+    eng::MatchingEngine engine(config_file_name);
+    std::vector<std::string> file_lines;
+    std::ifstream input_file(order_request_file_name);
+    for (std::string line; std::getline(input_file, line); )
+        file_lines.push_back(line);
+    
+    std::vector<std::string> lines;
+    for (std::size_t i = 0; i < copies; ++i)
+        lines.insert(lines.end(), file_lines.begin(), file_lines.end());
+    
+    lob::Order order;
+    {
+        std::size_t valid = 0;
+        Stopwatch watch;
+        for (const auto& line : lines)
+        {
+            try
+            {
+                nlohmann::json j = nlohmann::json::parse(line);
+                order.from_json(j, engine.tick_size_rule(), engine.lot_size());
+                ++valid;
+            }
+            catch(const std::exception& err) {}
+        }
+        report("decode, json document, per line", lines.size(), watch.elapsed());
+        std::cout << "  " << valid << " valid orders" << std::endl;
+    }
+    {
+        lob::OrderDecoder decoder;
+        lob::OrderFields fields;
+        std::size_t valid = 0;
+        Stopwatch watch;
+        for (const auto& line : lines)
+        {
+            if (decoder.decode(line.data(), line.data() + line.size(), fields) &&
+                order.from_fields(fields, engine.tick_size_rule(), engine.lot_size()) == lob::RejectReason::NONE)
+                ++valid;
+        }
+        report("decode, order decoder, per line", lines.size(), watch.elapsed());
+        std::cout << "  " << valid << " valid orders" << std::endl;
+    }
+    {
+        // the scan alone, without validating the fields
+        lob::OrderDecoder decoder;
+        lob::OrderFields fields;
+        std::int64_t checksum = 0;
+        Stopwatch watch;
+        for (const auto& line : lines)
+        {
+            if (decoder.decode(line.data(), line.data() + line.size(), fields))
+                checksum += fields.order_id;
+        }
+        report("decode, order decoder without validation, per line", lines.size(), watch.elapsed());
+        std::cout << "  checksum " << checksum << std::endl;
+    }
+}
+
+void bench::reject_throughput(const lib::FILE& config_file_name, std::size_t lines)
+{
+    eng::MatchingEngine engine(config_file_name);
+    
+    // decodable lines which all fail validation, for different reasons
+    const std::vector<std::string> invalid = {
+        R"({"limit_price":"136.38123","order_id":1,"quantity":100,"side":"SELL","symbol":"AAPL","time":1650681074,"type":"NEW"})",
+        R"({"limit_price":"136.38","order_id":2,"quantity":150,"side":"SELL","symbol":"AAPL","time":1650681074,"type":"NEW"})",
+        R"({"limit_price":"136.38","order_id":3,"quantity":100,"side":"HOLD","symbol":"AAPL","time":1650681074,"type":"NEW"})",
+        R"({"limit_price":"136.38","order_id":4,"side":"BUY","symbol":"AAPL","time":1650681074,"type":"NEW"})"};
+    lob::OrderDecoder decoder;
+    std::vector<lob::OrderFields> decoded(invalid.size());
+    for (std::size_t i = 0; i < invalid.size(); ++i)
+        decoder.decode(invalid[i].data(), invalid[i].data() + invalid[i].size(), decoded[i]);
+    
+    lob::Order order;
+    {
+        // the former control flow: every reject unwinds to a handler per line
+        std::size_t rejected = 0;
+        Stopwatch watch;
+        for (std::size_t i = 0; i < lines; ++i)
+        {
+            try
+            {
+                const lob::RejectReason reason = order.from_fields(decoded[i % decoded.size()], engine.tick_size_rule(), engine.lot_size());
+                if (reason != lob::RejectReason::NONE)
+                    throw std::invalid_argument(lob::reject_reason_str(reason));
+            }
+            catch(const std::exception& err)
+            {
+                ++rejected;
+            }
+        }
+        report("reject, thrown per line", rejected, watch.elapsed());
+    }
+    {
+        lob::RejectStats rejects;
+        Stopwatch watch;
+        for (std::size_t i = 0; i < lines; ++i)
+        {
+            const lob::RejectReason reason = order.from_fields(decoded[i % decoded.size()], engine.tick_size_rule(), engine.lot_size());
+            if (reason != lob::RejectReason::NONE)
+                rejects.add(reason, i + 1);
+        }
+        report("reject, counted by reason", rejects.total(), watch.elapsed());
+        nlohmann::json j;
+        rejects.to_json(j);
+        std::cout << "  " << j.dump() << std::endl;
+    }
+}
+
+void bench::price_codec(std::size_t prices)
+{
+    // prices of 1 to 4 decimals, as the request files carry them
+    std::mt19937_64 generator(42);
+    std::uniform_int_distribution<lib::t_price> distribution(1, 5000000);
+    std::vector<std::string> texts;
+    for (std::size_t i = 0; i < prices; ++i)
+        texts.push_back(lib::Price4(distribution(generator)).to_str());
+    
+    {
+        lib::t_price checksum = 0;
+        Stopwatch watch;
+        for (const auto& text : texts)
+            checksum += static_cast<lib::t_price>(std::stold(text) * 10000);
+        report("price parse, stold", prices, watch.elapsed());
+        std::cout << "  checksum " << checksum << std::endl;
+    }
+    {
+        lib::t_price checksum = 0;
+        std::size_t rounded = 0;
+        Stopwatch watch;
+        for (const auto& text : texts)
+        {
+            lib::Price4 price{};
+            lib::Price4::parse(text, price);
+            checksum += price.unscaled();
+        }
+        const double seconds = watch.elapsed();
+        for (const auto& text : texts)
+        {
+            lib::Price4 price{};
+            lib::Price4::parse(text, price);
+            rounded += static_cast<lib::t_price>(std::stold(text) * 10000) != price.unscaled();
+        }
+        report("price parse, exact", prices, seconds);
+        std::cout << "  checksum " << checksum << ", " << rounded << " prices stold got wrong" << std::endl;
+    }
+    
+    std::vector<lib::t_price> unscaled;
+    for (std::size_t i = 0; i < prices; ++i)
+        unscaled.push_back(distribution(generator));
+    {
+        std::size_t bytes = 0;
+        Stopwatch watch;
+        for (lib::t_price price : unscaled)
+            bytes += std::to_string(1.0 * price / 10000).size();
+        report("price format, to_string(double)", prices, watch.elapsed());
+        std::cout << "  " << bytes << " bytes" << std::endl;
+    }
+    {
+        std::size_t bytes = 0;
+        char text[lib::Price4::MAX_STR_SIZE];
+        Stopwatch watch;
+        for (lib::t_price price : unscaled)
+            bytes += lib::Price4(price).format(text) - text;
+        report("price format, Price4::format", prices, watch.elapsed());
+        std::cout << "  " << bytes << " bytes" << std::endl;
+    }
+}
+
+void bench::wire_throughput(const lib::FILE& order_request_file_name, const lib::FILE& config_file_name)
+{
+    const lib::FILE wire_file_name = order_request_file_name + ".bin";
+    {
+        eng::MatchingEngine engine(config_file_name);
+        Stopwatch watch;
+        const lob::RejectStats rejects = lob::json_to_wire(order_request_file_name, wire_file_name, engine.tick_size_rule(), engine.lot_size());
+        std::cout << "wire, convert: " << watch.elapsed() << " s, " << rejects.total() << " lines rejected" << std::endl;
+    }
+    
+    {
+        eng::MatchingEngine engine(config_file_name);
+        lob::OrderParser parser;
+        std::int64_t checksum = 0;
+        Stopwatch watch;
+        const std::size_t orders = parser.for_each(order_request_file_name, engine.tick_size_rule(), engine.lot_size(),
+                                                   [&](lob::Order& order) { checksum += order.order_qty(); });
+        report("wire, read json lines, per order", orders, watch.elapsed());
+        std::cout << "  checksum " << checksum << std::endl;
+    }
+    {
+        std::int64_t checksum = 0;
+        Stopwatch watch;
+        lob::WireReader reader(wire_file_name);
+        for (const lob::WireOrder& order : reader)
+            checksum += order.status_code() == lib::OrderStatus::CANCEL ? 0 : order.order_qty();
+        report("wire, read binary messages, per order", reader.size(), watch.elapsed());
+        std::cout << "  checksum " << checksum << std::endl;
+    }
+    
+    {
+        eng::MatchingEngine engine(config_file_name);
+        Stopwatch watch;
+        {
+            MuteStdout mute;
+            engine.match_orders(order_request_file_name);
+        }
+        std::cout << "wire, match json lines: " << watch.elapsed() << " s" << std::endl;
+    }
+    {
+        eng::MatchingEngine engine(config_file_name);
+        Stopwatch watch;
+        {
+            MuteStdout mute;
+            engine.match_wire_orders(wire_file_name);
+        }
+        std::cout << "wire, match binary messages: " << watch.elapsed() << " s" << std::endl;
+    }
+}
@@ -0,0 +1,124 @@
+/// @file arena.h
+/// @brief This is a file to implement fixed-size arenas backed by anonymous memory mappings.
+/// @author Shangwen Sun
+/// @date 04/30/2022
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include <sys/mman.h>
+
+#include "boost/noncopyable.hpp"
+
+namespace lib
+{
+
+constexpr std::size_t HUGE_PAGE_SIZE = std::size_t(2) << 20; // 2MB huge pages
+
+/// @brief How the pages of an arena are backed and faulted in.
+struct ArenaOptions
+{
+    bool huge_pages = false; // back with MAP_HUGETLB pages if reserved, transparent huge pages otherwise
+    bool prefault = false; // fault every page in up front (MAP_POPULATE) instead of on first touch
+    bool lock = false; // mlock the arena so it is never swapped out
+};
+
+/// @brief Raw storage for a fixed number of objects in an anonymous mapping.
+///        The kernel hands out zero-filled pages on first touch, so creating even a huge arena costs
+///        one system call and no initialisation loop; objects are constructed by the owner on first use.
+template <class T>
+class MmapArena : public boost::noncopyable
+{
+public:
+    MmapArena(std::size_t size, const ArenaOptions& options = ArenaOptions());
+    ~MmapArena();
+
+    /// @brief swap the mappings of two arenas
+    void swap(MmapArena& other);
+
+    T* data() const { return data_; }
+    T& operator[](std::size_t i) const { return data_[i]; }
+
+    /// @brief number of objects the arena holds
+    std::size_t size() const { return size_; }
+
+    /// @brief bytes mapped by the arena
+    std::size_t bytes() const { return bytes_; }
+
+private:
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t bytes_ = 0;
+};
+
+template <class T>
+MmapArena<T>::MmapArena(std::size_t size, const ArenaOptions& options) : size_(size)
+{
+    if (size == 0)
+        return;
+
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    // a lazy arena only costs what is touched, so don't let overcommit accounting refuse thousands of them
+    if (!options.prefault && !options.lock)
+        flags |= MAP_NORESERVE;
+#endif
+#ifdef MAP_POPULATE
+    if (options.prefault)
+        flags |= MAP_POPULATE;
+#endif
+
+    void* addr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (options.huge_pages)
+    {
+        // explicit huge pages need a reserved pool and a multiple of the 2MB page size
+        bytes_ = (size * sizeof(T) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        addr = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (addr == MAP_FAILED)
+    {
+        bytes_ = size * sizeof(T);
+        addr = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (addr == MAP_FAILED)
+            throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        if (options.huge_pages)
+            madvise(addr, bytes_, MADV_HUGEPAGE);
+#endif
+    }
+
+#ifndef MAP_POPULATE
+    if (options.prefault)
+    {
+        // touch one byte per page
+        for (std::size_t offset = 0; offset < bytes_; offset += 4096)
+            static_cast<volatile char*>(addr)[offset] = 0;
+    }
+#endif
+    if (options.lock)
+        mlock(addr, bytes_);
+
+    data_ = static_cast<T*>(addr);
+}
+
+template <class T>
+MmapArena<T>::~MmapArena()
+{
+    if (data_)
+        munmap(data_, bytes_);
+}
+
+template <class T>
+void MmapArena<T>::swap(MmapArena& other)
+{
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(bytes_, other.bytes_);
+}
+
+}
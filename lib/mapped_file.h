@@ -0,0 +1,77 @@
+/// @file mapped_file.h
+/// @brief This is a file to implement a read-only memory mapping of a whole file.
+/// @author Shangwen Sun
+/// @date 05/05/2022
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "boost/noncopyable.hpp"
+
+#include "types.h"
+
+namespace lib
+{
+
+/// @brief The bytes of a file mapped read-only into memory, so it can be read in place without copying it
+///        into stream buffers. The kernel reads the pages ahead of a sequential scan.
+class MappedFile : public boost::noncopyable
+{
+public:
+    explicit MappedFile(const FILE& file_name);
+    ~MappedFile();
+    
+    const char* data() const { return data_; }
+    
+    /// @brief size of the file in bytes
+    std::size_t size() const { return size_; }
+    
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+inline MappedFile::MappedFile(const FILE& file_name)
+{
+    const int fd = ::open(file_name.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        std::cout << "FAILED TO OPEN " << file_name << ".\n";
+        throw std::exception();
+    }
+    
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0)
+    {
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            ::close(fd);
+            std::cout << "FAILED TO MAP " << file_name << ".\n";
+            throw std::exception();
+        }
+        madvise(addr, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(addr);
+    }
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+}
+
+inline MappedFile::~MappedFile()
+{
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+}
+
+} // namespace lib
@@ -5,8 +5,12 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include "types.h"
 
@@ -24,17 +28,43 @@ public:
     explicit Price4(t_price unscaled) : unscaled_(unscaled) {}
     
     /// @brief Convert string stored price to unscaled
-    explicit Price4(const std::string& str)
+    explicit Price4(const std::string& str) : Price4(std::string_view(str)) {}
+    
+    /// @brief Convert a zero terminated price text to unscaled, without building a string
+    explicit Price4(const char* str) : Price4(std::string_view(str)) {}
+    
+    /// @brief Convert a price text to unscaled, throws std::invalid_argument if it is not an exact price
+    explicit Price4(std::string_view str)
     {
-        unscaled_ = std::stold(str) * 10000;
-    };
+        if (!parse(str, *this))
+            throw std::invalid_argument("Price4: not a price with at most 4 decimals");
+    }
+    
+    /// @brief Convert a decimal price text to unscaled exactly, without floating point and without throwing.
+    ///        Accepts an optional sign, digits and an optional fraction; decimals past the 4th must be zeros.
+    /// @return false if the text is not such a number, has more than 4 significant decimals or overflows
+    static bool parse(const char* begin, const char* end, Price4& price);
+    
+    static bool parse(std::string_view text, Price4& price)
+    {
+        return parse(text.data(), text.data() + text.size(), price);
+    }
     
     t_price unscaled() const { return unscaled_; }
+    
+    static constexpr std::size_t MAX_STR_SIZE = 28; // sign, 19 integer digits, the point and 6 decimals, with room to spare
+    
+    /// @brief Write the price as decimal text with 6 decimals, the width to_str() always had, e.g. 139.96 as "139.960000",
+    ///        without a terminator; the 2 decimals past the scale are always zeros
+    /// @param out at least MAX_STR_SIZE bytes
+    /// @return the end of the text
+    char* format(char* out) const;
         
     /// @brief Convert price to string for output
     std::string to_str() const
     {
-        return std::to_string(1.0 * unscaled_ / 10000); // # would it be faster if using boost::lexical_cast?
+        char text[MAX_STR_SIZE];
+        return std::string(text, format(text));
     };
     
     // operator overloading
@@ -76,4 +106,76 @@ public:
     
 };
 
+inline bool Price4::parse(const char* begin, const char* end, Price4& price)
+{
+    constexpr std::uint64_t max_integer = std::numeric_limits<t_price>::max() / 10000;
+    const char* p = begin;
+    const bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+'))
+        ++p;
+    
+    // integer part, stopping as soon as it can't fit any more
+    std::uint64_t integer = 0;
+    const char* digits = p;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+        integer = integer * 10 + (*p - '0');
+        if (integer > max_integer)
+            return false;
+    }
+    bool any_digit = p != digits;
+    
+    // fraction, padded to 4 decimals
+    std::uint64_t fraction = 0;
+    if (p < end && *p == '.')
+    {
+        ++p;
+        int decimals = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p, ++decimals)
+        {
+            if (decimals < 4)
+                fraction = fraction * 10 + (*p - '0');
+            else if (*p != '0')
+                return false; // finer than the scale
+        }
+        any_digit = any_digit || decimals > 0;
+        for (; decimals < 4; ++decimals)
+            fraction *= 10;
+    }
+    if (!any_digit || p != end)
+        return false;
+    
+    const std::uint64_t unscaled = integer * 10000 + fraction;
+    if (unscaled > static_cast<std::uint64_t>(std::numeric_limits<t_price>::max()))
+        return false;
+    price.unscaled_ = negative ? -static_cast<t_price>(unscaled) : static_cast<t_price>(unscaled);
+    return true;
+}
+
+inline char* Price4::format(char* out) const
+{
+    std::uint64_t magnitude = unscaled_ < 0 ? 0 - static_cast<std::uint64_t>(unscaled_) : static_cast<std::uint64_t>(unscaled_);
+    if (unscaled_ < 0)
+        *out++ = '-';
+    
+    // 2 zeros past the scale, the 4 decimals, then the integer part, written backwards into a scratch buffer
+    char digits[MAX_STR_SIZE];
+    char* p = digits + MAX_STR_SIZE;
+    *--p = '0';
+    *--p = '0';
+    for (int i = 0; i < 4; ++i, magnitude /= 10)
+        *--p = static_cast<char>('0' + magnitude % 10);
+    *--p = '.';
+    do
+    {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    
+    const std::size_t size = digits + MAX_STR_SIZE - p;
+    for (std::size_t i = 0; i < size; ++i)
+        out[i] = p[i];
+    return out + size;
+}
+
 }
@@ -0,0 +1,223 @@
+/// @file spsc_ring.h
+/// @brief This is a file to implement a bounded single-producer single-consumer ring connecting two threads.
+/// @author Shangwen Sun
+/// @date 05/03/2022
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "boost/noncopyable.hpp"
+
+namespace lib
+{
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/// @brief What a thread does while its ring is empty (consumer) or full (producer).
+enum class WaitStrategy
+{
+    BUSY_SPIN = 0, // spin on the cache line, lowest latency, burns a core
+    YIELD = 1, // spin briefly, then give the core to other threads between polls
+    FUTEX = 2, // spin briefly, then sleep in the kernel until the other side signals
+};
+
+/// @brief hint the cpu that we are in a spin loop
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/// @brief A wake-up word a thread can sleep on until a condition holds, shared by any number of rings.
+///        Signalling is free while nobody sleeps on it, so spinning strategies pay nothing for it.
+class WaitSignal : public boost::noncopyable
+{
+public:
+    /// @brief return once cond() holds, waiting according to the strategy
+    template <class Cond>
+    void wait(WaitStrategy strategy, Cond cond);
+
+    /// @brief wake the threads sleeping on the signal, after the condition they wait for was made true
+    void notify();
+
+private:
+    static constexpr int SPIN_LIMIT = 256; // polls before yielding or sleeping
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> sequence_{0};
+    std::atomic<std::uint32_t> sleepers_{0};
+};
+
+template <class Cond>
+void WaitSignal::wait(WaitStrategy strategy, Cond cond)
+{
+    // cond() may act (e.g. pop an item) when it holds, so it is never evaluated again after returning true
+    for (int spin = 0; !cond(); ++spin)
+    {
+        if (strategy == WaitStrategy::BUSY_SPIN || spin < SPIN_LIMIT)
+            cpu_relax();
+        else if (strategy == WaitStrategy::YIELD)
+            std::this_thread::yield();
+        else
+        {
+            // announce the sleeper before the last check, so a notify after it can't be missed
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const std::uint32_t sequence = sequence_.load(std::memory_order_acquire);
+            const bool ready = cond();
+            if (!ready)
+            {
+#if defined(__linux__)
+                // returns at once if a notify bumped the sequence since we read it
+                syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&sequence_), FUTEX_WAIT_PRIVATE, sequence, nullptr, nullptr, 0);
+#else
+                std::this_thread::yield();
+#endif
+            }
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            if (ready)
+                return;
+        }
+    }
+}
+
+inline void WaitSignal::notify()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) == 0)
+        return;
+
+    sequence_.fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&sequence_), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+/// @brief A bounded ring of T between exactly one producer and one consumer thread.
+///        Head and tail sit on their own cache lines and each side keeps a cached copy of the other's index,
+///        so a push or pop touches the shared lines only when the cached view runs out.
+///        Several rings may report new items to one consumer-side signal, for a consumer polling many rings.
+template <class T>
+class SpscRing : public boost::noncopyable
+{
+public:
+    /// @param capacity rounded up to a power of two
+    /// @param not_empty signal notified after each push, the ring's own signal if null
+    explicit SpscRing(std::size_t capacity, WaitStrategy strategy = WaitStrategy::YIELD, WaitSignal* not_empty = nullptr);
+
+    /// @brief move an item in if there is room
+    bool try_push(T& value);
+
+    /// @brief move an item in, waiting while the ring is full
+    void push(T value);
+
+    /// @brief move the oldest item out if there is one
+    bool try_pop(T& value);
+
+    /// @brief move the oldest item out, waiting while the ring is empty
+    void pop(T& value);
+
+    /// @brief is the ring empty? exact on the consumer thread, a snapshot elsewhere
+    bool empty() const;
+
+    std::size_t capacity() const { return slots_.size(); }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_;
+    WaitStrategy strategy_;
+    WaitSignal* not_empty_;
+    WaitSignal own_not_empty_;
+    WaitSignal not_full_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head_{0}; // next slot to pop, written by the consumer
+    std::size_t cached_tail_ = 0; // the consumer's view of tail_
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail_{0}; // next slot to push, written by the producer
+    std::size_t cached_head_ = 0; // the producer's view of head_
+};
+
+template <class T>
+SpscRing<T>::SpscRing(std::size_t capacity, WaitStrategy strategy, WaitSignal* not_empty)
+    : strategy_(strategy), not_empty_(not_empty ? not_empty : &own_not_empty_)
+{
+    std::size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+    slots_.resize(size);
+    mask_ = size - 1;
+}
+
+template <class T>
+bool SpscRing<T>::try_push(T& value)
+{
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == slots_.size())
+    {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail - cached_head_ == slots_.size())
+            return false;
+    }
+
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    if (strategy_ == WaitStrategy::FUTEX)
+        not_empty_->notify();
+    return true;
+}
+
+template <class T>
+void SpscRing<T>::push(T value)
+{
+    if (try_push(value))
+        return;
+    not_full_.wait(strategy_, [&]() { return try_push(value); });
+}
+
+template <class T>
+bool SpscRing<T>::try_pop(T& value)
+{
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_)
+    {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head == cached_tail_)
+            return false;
+    }
+
+    value = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    if (strategy_ == WaitStrategy::FUTEX)
+        not_full_.notify();
+    return true;
+}
+
+template <class T>
+void SpscRing<T>::pop(T& value)
+{
+    if (try_pop(value))
+        return;
+    not_empty_->wait(strategy_, [&]() { return try_pop(value); });
+}
+
+template <class T>
+bool SpscRing<T>::empty() const
+{
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+}
+
+} // namespace lib
@@ -0,0 +1,82 @@
+/// @file symbols.h
+/// @brief This is a file to implement a registry interning instrument symbols as dense integer ids.
+/// @author Shangwen Sun
+/// @date 05/02/2022
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+namespace lib
+{
+
+/// @brief Interns symbols as ids 0, 1, 2, ... in order of first appearance.
+///        The parser interns the symbol of each new order it decodes, so the string is hashed there once;
+///        from then on the order carries the id, which indexes flat per-symbol tables such as the engine's books.
+class SymbolRegistry
+{
+public:
+    SymbolRegistry() = default;
+    
+    /// @brief get the id of a symbol, registering it if it is new
+    /// @return the id, or NO_SYMBOL_ID if the symbol is new and every id is taken
+    t_symbol_id intern(const t_symbol& symbol);
+    
+    /// @brief get the id of a symbol, or NO_SYMBOL_ID if it was never registered
+    t_symbol_id find(const t_symbol& symbol) const;
+    
+    /// @brief get the symbol of an id
+    const t_symbol& name(t_symbol_id symbol_id) const;
+    
+    /// @brief number of registered symbols
+    std::size_t size() const;
+    
+    /// @brief forget every symbol, ids start from 0 again
+    void clear();
+    
+private:
+    std::unordered_map<t_symbol, t_symbol_id> ids_;
+    std::vector<t_symbol> names_; // indexed by symbol id
+};
+
+inline t_symbol_id SymbolRegistry::intern(const t_symbol& symbol)
+{
+    // a known symbol is only looked up: emplace would build a node, copying the string, before finding it
+    const auto it = ids_.find(symbol);
+    if (it != ids_.end())
+        return it->second;
+    if (names_.size() >= NO_SYMBOL_ID)
+        return NO_SYMBOL_ID;
+    const t_symbol_id symbol_id = static_cast<t_symbol_id>(names_.size());
+    ids_.emplace(symbol, symbol_id);
+    names_.push_back(symbol);
+    return symbol_id;
+}
+
+inline t_symbol_id SymbolRegistry::find(const t_symbol& symbol) const
+{
+    const auto it = ids_.find(symbol);
+    return it == ids_.end() ? NO_SYMBOL_ID : it->second;
+}
+
+inline const t_symbol& SymbolRegistry::name(t_symbol_id symbol_id) const
+{
+    return names_[symbol_id];
+}
+
+inline std::size_t SymbolRegistry::size() const
+{
+    return names_.size();
+}
+
+inline void SymbolRegistry::clear()
+{
+    ids_.clear();
+    names_.clear();
+}
+
+} // namespace lib
@@ -32,8 +32,9 @@ bool TickSizeRule::FromJson(const nlohmann::json &tick_json)
     }
 
     std::sort(ticks.begin(), ticks.end(), [](const Tick &lhs, const Tick &rhs){return lhs.from_price < rhs.from_price;});
+    compile();
 
-    for (std::size_t i = 0; i < ticks.size() - 1; ++i)
+    for (std::size_t i = 0; i + 1 < ticks.size(); ++i)
     {
         if (ticks[i].from_price >= ticks[i].to_price)
         {
@@ -48,3 +49,20 @@ bool TickSizeRule::FromJson(const nlohmann::json &tick_json)
     return ticks.empty() ? false : true;
 }
 
+
+
+void TickSizeRule::compile()
+{
+    bands.clear();
+    t_tick_index first_tick = 0;
+    for (const auto &tick : ticks)
+    {
+        TickBand band;
+        band.from_price = tick.from_price.unscaled();
+        band.to_price = tick.to_price.unscaled();
+        band.tick_units = tick.tick_units();
+        band.first_tick = first_tick;
+        bands.push_back(band);
+        first_tick += (band.to_price - band.from_price) / band.tick_units;
+    }
+}
@@ -4,6 +4,8 @@
 /// @date 04/02/2022
 
 #pragma once
+#include <cmath>
+
 #include "nlohmann/json.hpp"
 
 #include "price4.h"
@@ -24,6 +26,22 @@ struct Tick
     Price4 from_price;
     Price4 to_price = Price4(std::numeric_limits<t_price>::max());
     t_tick tick_size = 0.0;
+    
+    /// @brief Get the tick size in unscaled Price4 units (at least one unit)
+    t_price tick_units() const
+    {
+        const t_price units = std::llround(tick_size * 10000);
+        return units > 0 ? units : 1;
+    }
+};
+
+/// @brief A band of the schedule compiled to integers, so a price is checked and indexed without floating point.
+struct TickBand
+{
+    t_price from_price; // unscaled, the first price of the band
+    t_price to_price; // unscaled, the first price of the next band
+    t_price tick_units; // tick size in Price4 units
+    t_tick_index first_tick; // tick index of from_price, the ticks of all the bands below
 };
 
 // A class read tick size rule from a JSON file which could support arbitrary breakpoints in the schedule.
@@ -31,6 +49,16 @@ class TickSizeRule
 {
 private:
     std::vector<Tick> ticks;
+    std::vector<TickBand> bands; // compiled from ticks once the schedule is read
+    
+    /// @brief build the integer band table from the ticks
+    void compile();
+    
+    /// @brief the band a price falls in, the lowest band for prices below the schedule
+    const TickBand& band_of_price(t_price price) const;
+    
+    /// @brief the band a tick index falls in, the lowest band for negative indexes
+    const TickBand& band_of_tick(t_tick_index tick) const;
     
 public:
     TickSizeRule() = default;
@@ -42,6 +70,64 @@ public:
     {
         return ticks;
     }
+    
+    /// @brief get the compiled bands, in price order
+    const std::vector<TickBand>& GetBands() const
+    {
+        return bands;
+    }
+    
+    /// @brief Is an unscaled price a whole number of ticks above the start of its band? -> one band lookup and a modulo
+    ///        Without any band, every Price4 unit is a tick.
+    bool is_on_tick(t_price price) const;
+    
+    /// @brief Convert an unscaled price to its tick index, counting ticks band by band from the bottom of the schedule.
+    ///        Without any band, every Price4 unit is a tick.
+    t_tick_index price_to_tick(t_price price) const;
+    
+    /// @brief Convert a tick index back to the unscaled price
+    t_price tick_to_price(t_tick_index tick) const;
 };
 
+inline const TickBand& TickSizeRule::band_of_price(t_price price) const
+{
+    // schedules have a handful of bands, a linear scan beats a binary search there
+    std::size_t i = 0;
+    while (i + 1 < bands.size() && price >= bands[i + 1].from_price)
+        ++i;
+    return bands[i];
+}
+
+inline const TickBand& TickSizeRule::band_of_tick(t_tick_index tick) const
+{
+    std::size_t i = 0;
+    while (i + 1 < bands.size() && tick >= bands[i + 1].first_tick)
+        ++i;
+    return bands[i];
+}
+
+inline bool TickSizeRule::is_on_tick(t_price price) const
+{
+    if (bands.empty())
+        return true;
+    const TickBand& band = band_of_price(price);
+    return price >= band.from_price && (price - band.from_price) % band.tick_units == 0;
+}
+
+inline t_tick_index TickSizeRule::price_to_tick(t_price price) const
+{
+    if (bands.empty())
+        return price;
+    const TickBand& band = band_of_price(price);
+    return band.first_tick + (price - band.from_price) / band.tick_units;
+}
+
+inline t_price TickSizeRule::tick_to_price(t_tick_index tick) const
+{
+    if (bands.empty())
+        return tick;
+    const TickBand& band = band_of_tick(tick);
+    return band.from_price + (tick - band.first_tick) * band.tick_units;
+}
+
 }
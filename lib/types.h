@@ -10,9 +10,11 @@ namespace lib
 typedef std::time_t t_time;
 typedef std::uint64_t t_orderid;
 typedef std::int32_t t_quantity;
+typedef std::int64_t t_volume; // sum of quantities, e.g. over a price level
 typedef std::int64_t t_price;
 
 typedef double t_tick;
+typedef std::int64_t t_tick_index; // the number of ticks between a price and the bottom of the tick size schedule
 typedef std::uint32_t t_lot;
 typedef bool t_side;
 
@@ -60,6 +62,8 @@ enum class TimeInForce
 //    CSCO
 //};
 typedef std::string t_symbol;
+typedef std::uint32_t t_symbol_id; // dense id of an interned symbol, the index of its order book
+constexpr t_symbol_id NO_SYMBOL_ID = static_cast<t_symbol_id>(-1); // a symbol which was not interned yet
 //static std::map<Symbol, std::string> symbolStr{
 //                                {Symbol::AAPL, "AAPL"},
 //                                {Symbol::MSFT, "MSFT"},
@@ -11,7 +11,6 @@
 #include <list>
 
 #include "boost/noncopyable.hpp"
-#include "boost/intrusive/slist.hpp"
 #include "boost/intrusive/list.hpp"
 
 // namespace lib
@@ -20,6 +19,12 @@
 // namespace lob
 #include "order.h"
 #include "order_entry.h"
+#include "level_store.h"
+#include "order_index.h"
+#include "entry_pool.h"
+#include "depth_cache.h"
+#include "reject.h"
+#include "book_listener.h"
 //#include "parser.h"
 
 // namespace notify
@@ -31,10 +36,46 @@ namespace lob
 #define MAX_NUM_ORDERS 10010000
 #define MAX_LIVE_ORDERS 10010000
 #define MAX_ORDER_QUANTITY 10001000
-#define MAX_PRICEPOINT_NUM 10000000
+
+struct WireOrder;
+
+constexpr lib::t_tick_index NO_ASK = NO_LEVEL_ABOVE; // askMin of an empty ask side
+constexpr lib::t_tick_index NO_BID = NO_LEVEL_BELOW; // bidMax of an empty bid side
+
+/// @brief The top price levels of both sides of a book, best first.
+///        It points into the book and is valid until the book changes.
+struct DepthSnapshot
+{
+    const DepthLevel* bids = nullptr;
+    std::size_t bid_count = 0;
+    const DepthLevel* asks = nullptr;
+    std::size_t ask_count = 0;
+    
+    void to_json(nlohmann::json& j) const;
+};
+
+/// @brief Memory footprint of a limit order book.
+struct BookMemoryReport
+{
+    std::size_t level_count = 0; // number of allocated price levels
+    std::size_t level_bytes = 0; // bytes held by the price levels
+    std::size_t entry_count = 0; // number of book entries in the arena
+    std::size_t entry_in_use = 0; // number of book entries resting in the book
+    std::size_t entry_high_water = 0; // the most book entries ever in use at once
+    std::size_t entry_bytes = 0; // bytes held by the book entry arena
+    std::size_t index_bytes = 0; // bytes held by the order id index
+    
+    std::size_t total_bytes() const { return level_bytes + entry_bytes + index_bytes; }
+    
+    void to_json(nlohmann::json& j) const;
+};
 
 /// @brief The limit order book of a security.
-class OrderBook : public boost::noncopyable
+///        Listener is the policy the book reports its adds, modifies, deletes and trades to, see book_listener.h;
+///        it is a member called without indirection, so the NullListener book only pays for matching.
+///        Its members are defined in book_impl.h, so a book can be built with any listener.
+template <class Listener = NullListener>
+class BasicOrderBook : public boost::noncopyable
 {
     /* we make this class noncopyable because it's a recursive data structure with
      * pointers to numerous smaller copies of itself maintained using list of pointers
@@ -43,14 +84,19 @@ class OrderBook : public boost::noncopyable
      */
     
 public:
-    typedef boost::intrusive::slist<OrderBookEntry, boost::intrusive::cache_last<true> > pricePoint; // describes a single price point in the limit order book.
+    typedef lob::pricePoint pricePoint; // describes a single price point in the limit order book.
+    typedef lob::PriceLevel PriceLevel; // a price point with its aggregated quantities
     
 public:
     /// @brief construct
-    OrderBook(const lib::t_symbol& symbol = "unknown");
+    /// @param arena_options paging of the entry arena and order index: lazy by default, optionally huge pages, prefaulted or locked
+    BasicOrderBook(const lib::t_symbol& symbol = "unknown",
+                   const lib::TickSizeRule& tick_size_rule = lib::TickSizeRule(),
+                   std::size_t max_live_orders = MAX_LIVE_ORDERS,
+                   const lib::ArenaOptions& arena_options = lib::ArenaOptions());
 
     //OrderBook(const std::string& notify_file_path, const nlohmann::json& tick_json, lib::t_lot lot_size);
-    ~OrderBook() = default;
+    ~BasicOrderBook() = default;
     
     /// @brief Set symbol for orders in this book.
     void set_symbol(const lib::t_symbol& symbol);
@@ -58,71 +104,127 @@ public:
     /// @brief Get the symbol for orders in this book
     const lib::t_symbol& symbol() const;
     
+    /// @brief Get the listener the book reports its events to, e.g. to attach it to a feed.
+    Listener& listener();
+    
+    /// @brief Set the tick size rule used to index price levels; only valid while the book is empty.
+    void set_tick_size_rule(const lib::TickSizeRule& tick_size_rule);
+    
     /// @brief Get current market price on the ask side.
     lib::t_price best_ask() const;
     
     /// @brief Get current market price on the bid side.
     lib::t_price best_bid() const;
     
+    /// @brief Get the aggregated quantities resting at a price -> O(1)
+    DepthLevel level(lib::t_price price) const;
+    
+    /// @brief Get the top n (at most MAX_DEPTH_LEVELS) price levels of each side from the top of book cache -> O(1)
+    DepthSnapshot depth(std::size_t n = MAX_DEPTH_LEVELS) const;
+    
 
-    /// @brief add an order to book
+    /// @brief add an order to book; a new order whose id is already resting is rejected and counted
     /// @param order the order to add
     /// @return true if the add resulted in a fill
     bool add(const Order& order);
     
+    /// @brief add an order read in place from a binary order file
+    /// @return true if the add resulted in a fill
+    bool add(const WireOrder& order);
+    
     
+    /// @brief is an order resting in the book? -> O(1)
+    bool contains(lib::t_orderid order_id) const;
     
     /// @brief cancel an order in the book
-    void cancel(lib::t_orderid request_id);
+    /// @return true if the order was resting in the book
+    bool cancel(lib::t_orderid request_id);
     
-    /// @brief replace an order in the book
-    /// @param order the order to replace
-    /// @param size_delta the change in size for the order (positive or negative)
-    /// @param new_price the new order price, or PRICE_UNCHANGED
-    /// @return true if the replace resulted in a fill
-    bool replace(const Order& order,
-                         lib::t_quantity size_delta,
-                         lib::t_price new_price);
-
+    /// @brief report the memory held by this book
+    BookMemoryReport memory_report() const;
     
-    ///@brief shutdown the orderbook at the end of a trading day
-    void shutdown();
+    /// @brief orders the book refused, by reason
+    const RejectStats& rejects() const;
     
 protected:
-    /// @brief match a new bid order to current orders
+    /// @brief matching policy of an incoming buy order: it lifts the asks from askMin upwards
+    struct BuySide
+    {
+        static constexpr bool is_buy = true;
+        static lib::t_tick_index& best(BasicOrderBook& book) { return book.askMin; }
+        static bool crosses(lib::t_tick_index orderTick, lib::t_tick_index best) { return best != NO_ASK && orderTick >= best; }
+        static lib::t_tick_index next(const LevelStore& levels, lib::t_tick_index tick) { return levels.next_occupied(tick + 1); }
+    };
+    
+    /// @brief matching policy of an incoming sell order: it hits the bids from bidMax downwards
+    struct SellSide
+    {
+        static constexpr bool is_buy = false;
+        static lib::t_tick_index& best(BasicOrderBook& book) { return book.bidMax; }
+        static bool crosses(lib::t_tick_index orderTick, lib::t_tick_index best) { return best != NO_BID && orderTick <= best; }
+        static lib::t_tick_index next(const LevelStore& levels, lib::t_tick_index tick) { return levels.prev_occupied(tick - 1); }
+    };
+    
+    /// @brief match a new order to current orders of the other side
     /// @return true if a match occurred
-    bool match_bid_order(OrderBookEntry& entry, lib::t_price orderPrice);
-    
-    /// @brief match a new ask order to current orders
-    /// @return true if a match occurred
-    bool match_ask_order(OrderBookEntry& entry, lib::t_price orderPrice);
+    template <class Side>
+    bool match_order(OrderBookEntry& entry, lib::t_tick_index orderTick);
     
     /// @brief perform fill on two orders
-    bool create_trade(OrderBookEntry& inbound_tracker, OrderBookEntry& current_tracker, lib::t_quantity matched_quantity);
+    void create_trade(OrderBookEntry& inbound_tracker, PriceLevel& level, OrderBookEntry& current_tracker, lib::t_quantity matched_quantity);
 
+    /// @brief show the next slice of an iceberg order whose visible quantity was filled
+    void replenish(PriceLevel& level, OrderBookEntry& current);
+    
+    /// @brief mark a price level which became empty and move the top of the book past it
+    void remove_level(lib::t_tick_index tick);
+    
+    /// @brief bring the top of book cache of a side in line with a price level that changed
+    void refresh_depth(bool is_buy, lib::t_tick_index tick);
+    
+    /// @brief match a new order, then rest what is left of it unless it is immediate-or-cancel
+    bool add_entry(OrderBookEntry& inbound, lib::t_price price, bool is_buy, bool immediate_or_cancel);
+    
     /// @brief insert a new order into arenaorderbook at a specific price level
-    bool insert_order(OrderBookEntry& inbound, lib::t_price orderPrice);
+    /// @return false if the entry pool or the outlier levels are exhausted, the order is dropped and counted as BOOK_FULL
+    bool insert_order(OrderBookEntry& inbound, lib::t_tick_index orderTick, bool is_buy);
     
  
 private:
     
     lib::t_symbol symbol_;
+    
+    // Maps prices to tick indices of the price levels
+    lib::TickSizeRule tick_size_rule_;
 
-    // An array of pricePoint structures representing the entire limit order book
-    std::vector<OrderBookEntry> arenaBookEntries;
-    std::vector<pricePoint> pricePoints;
+    // A fixed-size arena recycling the book entries, and the price levels over the active tick range of the book
+    EntryPool arenaBookEntries;
+    LevelStore pricePoints;
 
-    // Monotonically-increasing orderID -> access order via order_id -> O(1)
-    lib::t_orderid curOrderID;
+    // Arena slot of each resting order -> access order via order_id -> O(1)
+    OrderIndex orderIndex;
+    
+    // Tick index of the minimum Ask price -> O(1)
+    lib::t_tick_index askMin;
     
-    // Minimum Ask price -> O(1)
-    lib::t_price askMin;
+    // Tick index of the maximum Bid price -> O(1)
+    lib::t_tick_index bidMax;
     
-    // Maximum Bid price -> O(1)
-    lib::t_price bidMax;
+    // Top price levels of each side -> O(1)
+    DepthCache bidDepth;
+    DepthCache askDepth;
     
-    //notify::Notifier notifier;
+    // Orders refused by the book itself, e.g. a reused order id or a full entry pool
+    RejectStats rejects_;
+    
+    // Receives the events of the book, inlined into the matching loop
+    Listener listener_;
 };
 
+/// @brief The book without a listener, as the engine and the benchmarks use it.
+typedef BasicOrderBook<NullListener> OrderBook;
+
 
 } // namespace lob
+
+#include "book_impl.h"
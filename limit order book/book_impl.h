@@ -0,0 +1,386 @@
+/// @file book_impl.h
+/// @brief This is a file to implement the members of the limit order book class template, included by book.h.
+/// @author Shangwen Sun
+/// @date 05/13/2022
+
+#pragma once
+
+#include <type_traits>
+#include <algorithm>
+
+#include "types.h"
+#include "ticks.h"
+#include "wire.h"
+
+namespace lob
+{
+
+template <class Listener>
+BasicOrderBook<Listener>::BasicOrderBook(const lib::t_symbol& symbol, const lib::TickSizeRule& tick_size_rule, std::size_t max_live_orders, const lib::ArenaOptions& arena_options)
+    : symbol_(symbol),
+      tick_size_rule_(tick_size_rule),
+      arenaBookEntries(max_live_orders, arena_options),
+      orderIndex(arena_options),
+      bidDepth(true),
+      askDepth(false)
+{
+    // price levels are allocated lazily over the tick range the orders touch
+    askMin = NO_ASK;
+    bidMax = NO_BID;
+
+}
+
+template <class Listener>
+void BasicOrderBook<Listener>::set_symbol(const lib::t_symbol& symbol)
+{
+    symbol_ = symbol;
+}
+
+template <class Listener>
+const lib::t_symbol& BasicOrderBook<Listener>::symbol() const
+{
+    return symbol_;
+}
+
+template <class Listener>
+void BasicOrderBook<Listener>::set_tick_size_rule(const lib::TickSizeRule& tick_size_rule)
+{
+    if(askMin != NO_ASK || bidMax != NO_BID)
+        throw std::logic_error("Tick size rule can only be changed on an empty book!");
+    tick_size_rule_ = tick_size_rule;
+}
+
+template <class Listener>
+Listener& BasicOrderBook<Listener>::listener()
+{
+    return listener_;
+}
+
+template <class Listener>
+lib::t_price BasicOrderBook<Listener>::best_ask() const
+{
+    return askMin == NO_ASK ? MAX_PRICE : tick_size_rule_.tick_to_price(askMin);
+}
+
+template <class Listener>
+lib::t_price BasicOrderBook<Listener>::best_bid() const
+{
+    return bidMax == NO_BID ? MIN_PRICE : tick_size_rule_.tick_to_price(bidMax);
+}
+
+template <class Listener>
+DepthLevel BasicOrderBook<Listener>::level(lib::t_price price) const
+{
+    DepthLevel depth;
+    depth.price = price;
+    
+    const lib::t_tick_index tick = tick_size_rule_.price_to_tick(price);
+    if(!pricePoints.contains(tick))
+        return depth;
+    
+    const PriceLevel& ppEntry = pricePoints[tick];
+    depth.visible_qty = ppEntry.visible_qty;
+    depth.hidden_qty = ppEntry.hidden_qty;
+    depth.order_count = ppEntry.order_count;
+    return depth;
+}
+
+template <class Listener>
+DepthSnapshot BasicOrderBook<Listener>::depth(std::size_t n) const
+{
+    DepthSnapshot snapshot;
+    snapshot.bids = bidDepth.levels();
+    snapshot.bid_count = std::min(n, bidDepth.size());
+    snapshot.asks = askDepth.levels();
+    snapshot.ask_count = std::min(n, askDepth.size());
+    return snapshot;
+}
+
+template <class Listener>
+void BasicOrderBook<Listener>::refresh_depth(bool is_buy, lib::t_tick_index tick)
+{
+    DepthCache& cache = is_buy ? bidDepth : askDepth;
+    const PriceLevel& ppEntry = pricePoints[tick];
+    
+    if(!ppEntry.empty())
+    {
+        cache.update(tick, tick_size_rule_.tick_to_price(tick), ppEntry);
+        return;
+    }
+    
+    // an emptied level leaves the window, the best level behind a full window moves into it
+    const bool was_full = cache.full();
+    const lib::t_tick_index window_end = was_full ? cache.worst() : tick;
+    if(!cache.remove(tick) || !was_full)
+        return;
+    
+    const lib::t_tick_index next = is_buy ? pricePoints.prev_occupied(window_end - 1) : pricePoints.next_occupied(window_end + 1);
+    if(next != NO_BID && next != NO_ASK)
+        cache.update(next, tick_size_rule_.tick_to_price(next), pricePoints[next]);
+}
+
+template <class Listener>
+BookMemoryReport BasicOrderBook<Listener>::memory_report() const
+{
+    BookMemoryReport report;
+    report.level_count = pricePoints.size();
+    report.level_bytes = pricePoints.memory_usage();
+    report.entry_count = arenaBookEntries.capacity();
+    report.entry_in_use = arenaBookEntries.in_use();
+    report.entry_high_water = arenaBookEntries.high_water_mark();
+    report.entry_bytes = arenaBookEntries.memory_usage();
+    report.index_bytes = orderIndex.memory_usage();
+    return report;
+}
+
+template <class Listener>
+const RejectStats& BasicOrderBook<Listener>::rejects() const
+{
+    return rejects_;
+}
+
+template <class Listener>
+bool BasicOrderBook<Listener>::contains(lib::t_orderid order_id) const
+{
+    return orderIndex.find(order_id) != OrderIndex::npos;
+}
+
+template <class Listener>
+bool BasicOrderBook<Listener>::cancel(lib::t_orderid request_id)
+{
+    // look up the arena slot of the resting order -> O(1)
+    const std::uint32_t slot = orderIndex.find(request_id);
+    if(slot == OrderIndex::npos)
+        return false; // unknown, or filled or cancelled already
+
+    // unlink the entry from its price level -> O(1)
+    OrderBookEntry& entry = arenaBookEntries[slot];
+    PriceLevel& ppEntry = pricePoints[entry.tick];
+    ppEntry.orders.erase(ppEntry.orders.iterator_to(entry));
+    ppEntry.visible_qty -= entry.open_qty;
+    ppEntry.hidden_qty -= entry.order_qty - entry.open_qty;
+    --ppEntry.order_count;
+    
+    listener_.on_delete(request_id, entry.is_buy, tick_size_rule_.tick_to_price(entry.tick), ppEntry.visible_qty);
+    // the depth cache reads the level before an emptied outlier level is released
+    refresh_depth(entry.is_buy, entry.tick);
+    if(ppEntry.empty())
+        remove_level(entry.tick);
+    
+    orderIndex.erase(request_id);
+    arenaBookEntries.release(slot);
+    return true;
+}
+
+template <class Listener>
+void BasicOrderBook<Listener>::remove_level(lib::t_tick_index tick)
+{
+    pricePoints.set_empty(tick);
+    
+    // move the top of the book to the next price level
+    if(tick == askMin)
+        askMin = pricePoints.next_occupied(tick + 1);
+    else if(tick == bidMax)
+        bidMax = pricePoints.prev_occupied(tick - 1);
+}
+
+template <class Listener>
+bool BasicOrderBook<Listener>::add(const Order& order)
+{
+    // CANCEL ORDER
+    if(order.status() == lib::OrderStatus::CANCEL)
+    {
+        cancel(order.orderid());
+        return false;
+    }
+    
+    // NEW ORDER
+    // an incoming iceberg order trades its whole quantity, the display size only applies once it rests
+    OrderBookEntry inbound;
+    inbound.order_qty = order.order_qty();
+    inbound.open_qty = order.order_qty();
+    inbound.display_qty = order.open_qty();
+    inbound.order_id = order.orderid();
+    inbound.is_iceberg = order.is_iceberg();
+    inbound.is_gtc = order.good_till_cancel();
+    return add_entry(inbound, order.price(), order.is_buy(), order.immediate_or_cancel());
+}
+
+template <class Listener>
+bool BasicOrderBook<Listener>::add(const WireOrder& order)
+{
+    if(order.status_code() == lib::OrderStatus::CANCEL)
+    {
+        cancel(order.orderid());
+        return false;
+    }
+    
+    OrderBookEntry inbound;
+    inbound.order_qty = order.order_qty();
+    inbound.open_qty = order.order_qty();
+    inbound.display_qty = order.open_qty();
+    inbound.order_id = order.orderid();
+    inbound.is_iceberg = order.is_iceberg();
+    inbound.is_gtc = order.good_till_cancel();
+    return add_entry(inbound, order.limit_price(), order.is_buy(), order.immediate_or_cancel());
+}
+
+template <class Listener>
+bool BasicOrderBook<Listener>::add_entry(OrderBookEntry& inbound, lib::t_price price, bool is_buy, bool immediate_or_cancel)
+{
+    // a reused id would overwrite the index entry of the resting order, leaving that order unreachable
+    if(orderIndex.find(inbound.order_id) != OrderIndex::npos)
+    {
+        rejects_.add(RejectReason::DUPLICATE_ORDER_ID);
+        return false;
+    }
+    
+    bool matched = false;
+    const lib::t_tick_index orderTick = tick_size_rule_.price_to_tick(price);
+    
+     // LIMIT ORDER, MARKET ORDER, ICEBERG ORDER -> dispatch once to the side specialised matching loop
+    if(is_buy)
+        matched = match_order<BuySide>(inbound, orderTick);
+    else
+        matched = match_order<SellSide>(inbound, orderTick);
+
+    // IOC ORDER: the remaining quantity is cancelled instead of resting in the book
+    if(inbound.open_qty > 0 && !immediate_or_cancel && insert_order(inbound, orderTick, is_buy))
+    {
+        const PriceLevel& ppEntry = pricePoints[orderTick];
+        listener_.on_add(inbound.order_id, is_buy, tick_size_rule_.tick_to_price(orderTick), ppEntry.orders.back().open_qty, ppEntry.visible_qty);
+    }
+
+    return matched;
+}
+
+
+template <class Listener>
+void BasicOrderBook<Listener>::create_trade(OrderBookEntry& inbound, PriceLevel& level, OrderBookEntry& current, lib::t_quantity matched_quantity)
+{
+    inbound.open_qty -= matched_quantity;
+    inbound.order_qty -= matched_quantity;
+    current.open_qty -= matched_quantity;
+    current.order_qty -= matched_quantity;
+    
+    // keep the aggregates of the resting order's level in step
+    level.visible_qty -= matched_quantity;
+    if(current.order_qty == 0)
+        --level.order_count;
+}
+
+template <class Listener>
+void BasicOrderBook<Listener>::replenish(PriceLevel& level, OrderBookEntry& current)
+{
+    // the next slice of an iceberg order comes out of its hidden quantity
+    current.open_qty = std::min(current.display_qty, current.order_qty);
+    level.visible_qty += current.open_qty;
+    level.hidden_qty -= current.open_qty;
+}
+
+template <class Listener>
+bool BasicOrderBook<Listener>::insert_order(OrderBookEntry& inbound, lib::t_tick_index orderTick, bool is_buy)
+{
+    const std::uint32_t slot = arenaBookEntries.allocate();
+    if(slot == EntryPool::npos)
+    {
+        rejects_.add(RejectReason::BOOK_FULL);
+        return false;
+    }
+    
+    // a far price needs a free outlier level, the entry is given back if there is none
+    PriceLevel* const level = pricePoints.at(orderTick);
+    if(!level)
+    {
+        arenaBookEntries.release(slot);
+        rejects_.add(RejectReason::BOOK_FULL);
+        return false;
+    }
+    
+    auto entry = &arenaBookEntries[slot];
+    entry->open_qty = inbound.is_iceberg ? std::min(inbound.display_qty, inbound.order_qty) : inbound.order_qty;
+    entry->order_qty = inbound.order_qty;
+    entry->display_qty = inbound.display_qty;
+    entry->is_iceberg = inbound.is_iceberg;
+    entry->is_gtc = inbound.is_gtc;
+    entry->order_id = inbound.order_id;
+    entry->tick = orderTick;
+    entry->is_buy = is_buy;
+    PriceLevel& ppEntry = *level;
+    ppEntry.orders.push_back(*entry);
+    ppEntry.visible_qty += entry->open_qty;
+    ppEntry.hidden_qty += entry->order_qty - entry->open_qty;
+    ++ppEntry.order_count;
+    orderIndex.insert(entry->order_id, slot);
+    pricePoints.set_occupied(orderTick);
+    refresh_depth(is_buy, orderTick);
+    
+    // update bidMax/askMin if the order improves the top of the book
+    if(is_buy)
+    {
+        if (bidMax < orderTick) bidMax = orderTick;
+    }
+    else
+    {
+        if (askMin > orderTick) askMin = orderTick;
+    }
+    
+    return true;
+}
+
+// Try to match order.  Generate trades.
+// The caller adds the remaining quantity to the order book if not completely filled and not IOC
+template <class Listener>
+template <class Side>
+bool BasicOrderBook<Listener>::match_order(OrderBookEntry& entry, lib::t_tick_index orderTick)
+{
+    lib::t_tick_index& best = Side::best(*this);
+    const lib::t_quantity order_qty = entry.order_qty;
+    
+    // look for outstanding orders on the other side that cross with the incoming order
+    while(entry.open_qty > 0 && Side::crosses(orderTick, best))
+    {
+        const lib::t_tick_index tick = best;
+        const lib::t_price price = tick_size_rule_.tick_to_price(tick);
+        PriceLevel& ppEntry = pricePoints[tick];
+        auto bookEntry = ppEntry.orders.begin();
+        
+        // exhaust existing orders at this price level until the incoming order is filled;
+        // an exact fill or a replenished iceberg slice leaves it filled with orders still ahead
+        while (bookEntry != ppEntry.orders.end() && entry.open_qty > 0)
+        {
+            const lib::t_quantity matched_quantity = std::min(bookEntry->open_qty, entry.open_qty);
+            create_trade(entry, ppEntry, *bookEntry, matched_quantity);
+            listener_.on_trade(bookEntry->order_id, !Side::is_buy, price, matched_quantity, ppEntry.visible_qty);
+            if (bookEntry->open_qty != 0)
+                break; // the resting order outlives the incoming one
+            
+            if (bookEntry->order_qty != 0)
+            {
+                // ICEBERG ORDER: the next slice queues at the back of the level with new time priority
+                auto refreshed = bookEntry++;
+                replenish(ppEntry, *refreshed);
+                ppEntry.orders.splice(ppEntry.orders.end(), ppEntry.orders, refreshed);
+                listener_.on_modify(refreshed->order_id, !Side::is_buy, price, refreshed->open_qty, ppEntry.visible_qty);
+                continue;
+            }
+            
+            // delete the exhausted book entry and recycle its slot, then move on to next bookEntry at the same price level
+            listener_.on_delete(bookEntry->order_id, !Side::is_buy, price, ppEntry.visible_qty);
+            orderIndex.erase(bookEntry->order_id);
+            bookEntry = ppEntry.orders.erase_and_dispose(bookEntry, [this](OrderBookEntry* exhausted){ arenaBookEntries.release(*exhausted); });
+        }
+        
+        // We have exhausted all orders at this price point. Move on to next price level
+        refresh_depth(!Side::is_buy, tick);
+        if (ppEntry.empty())
+        {
+            pricePoints.set_empty(tick);
+            best = Side::next(pricePoints, tick);
+        }
+    }
+    
+    return entry.order_qty != order_qty;
+}
+
+} // namespace lob
@@ -0,0 +1,33 @@
+/// @file book_listener.h
+/// @brief This is a file to define the listener policy an order book reports its events to.
+/// @author Shangwen Sun
+/// @date 05/13/2022
+
+#pragma once
+
+#include "types.h"
+
+namespace lob
+{
+
+/* A listener policy of BasicOrderBook handles the events below. The book calls it from the matching loop, so the
+ * calls are resolved at compile time and inlined; each one passes the resting order, its side and price level,
+ * and the visible quantity of the level afterwards.
+ *
+ *   on_add(order_id, is_buy, price, qty, level_qty)     an order rests at a level, showing qty
+ *   on_modify(order_id, is_buy, price, qty, level_qty)  an iceberg order shows a new slice of qty, at the back of its level
+ *   on_delete(order_id, is_buy, price, level_qty)       a resting order left the book, cancelled or filled
+ *   on_trade(order_id, is_buy, price, qty, level_qty)   qty of a resting order was executed at its price
+ */
+
+/// @brief The listener of a book nobody listens to: every call is empty and compiles to nothing,
+///        so the book costs what its matching costs.
+struct NullListener
+{
+    void on_add(lib::t_orderid, bool, lib::t_price, lib::t_quantity, lib::t_volume) {}
+    void on_modify(lib::t_orderid, bool, lib::t_price, lib::t_quantity, lib::t_volume) {}
+    void on_delete(lib::t_orderid, bool, lib::t_price, lib::t_volume) {}
+    void on_trade(lib::t_orderid, bool, lib::t_price, lib::t_quantity, lib::t_volume) {}
+};
+
+} // namespace lob
@@ -0,0 +1,134 @@
+/// @file depth_cache.h
+/// @brief This is a file to implement the cache of the top price levels of one side of a limit order book.
+/// @author Shangwen Sun
+/// @date 04/29/2022
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "types.h"
+#include "level_store.h"
+
+namespace lob
+{
+
+#define MAX_DEPTH_LEVELS 10 // number of price levels kept per side in the top of book cache
+
+/// @brief Aggregated view of one price level.
+struct DepthLevel
+{
+    lib::t_price price = 0;
+    lib::t_volume visible_qty = 0; // displayed quantity
+    lib::t_volume hidden_qty = 0; // undisplayed iceberg quantity
+    std::uint32_t order_count = 0;
+};
+
+/// @brief The best MAX_DEPTH_LEVELS price levels of one side, sorted best first.
+///        It always holds the min(MAX_DEPTH_LEVELS, number of levels) best levels of the side;
+///        the book refreshes it only for levels it touches, and touches outside a full window cost one comparison.
+class DepthCache
+{
+public:
+    explicit DepthCache(bool is_bid) : is_bid_(is_bid) {}
+
+    /// @brief is tick index a in front of tick index b on this side?
+    bool better(lib::t_tick_index a, lib::t_tick_index b) const;
+
+    /// @brief does the cache hold MAX_DEPTH_LEVELS levels?
+    bool full() const;
+
+    /// @brief tick index of the last cached level, the cache must not be empty
+    lib::t_tick_index worst() const;
+
+    /// @brief store the aggregates of a non-empty level, if it belongs to the window
+    void update(lib::t_tick_index tick, lib::t_price price, const PriceLevel& level);
+
+    /// @brief drop a level which became empty
+    /// @return true if the level was cached
+    bool remove(lib::t_tick_index tick);
+
+    /// @brief number of cached levels
+    std::size_t size() const;
+
+    /// @brief the cached levels, best first
+    const DepthLevel* levels() const;
+
+private:
+    bool is_bid_;
+    std::size_t size_ = 0;
+    std::array<lib::t_tick_index, MAX_DEPTH_LEVELS> ticks_;
+    std::array<DepthLevel, MAX_DEPTH_LEVELS> levels_;
+};
+
+inline bool DepthCache::better(lib::t_tick_index a, lib::t_tick_index b) const
+{
+    return is_bid_ ? a > b : a < b;
+}
+
+inline bool DepthCache::full() const
+{
+    return size_ == MAX_DEPTH_LEVELS;
+}
+
+inline lib::t_tick_index DepthCache::worst() const
+{
+    return ticks_[size_ - 1];
+}
+
+inline void DepthCache::update(lib::t_tick_index tick, lib::t_price price, const PriceLevel& level)
+{
+    // touches behind a full window don't change the top of the book
+    if (full() && better(worst(), tick))
+        return;
+
+    std::size_t i = 0;
+    while (i < size_ && better(ticks_[i], tick))
+        ++i;
+
+    if (i == size_ || ticks_[i] != tick)
+    {
+        // a new level enters the window, the worst one falls out if it is full
+        const std::size_t last = full() ? size_ - 1 : size_++;
+        for (std::size_t j = last; j > i; --j)
+        {
+            ticks_[j] = ticks_[j - 1];
+            levels_[j] = levels_[j - 1];
+        }
+        ticks_[i] = tick;
+        levels_[i].price = price;
+    }
+
+    levels_[i].visible_qty = level.visible_qty;
+    levels_[i].hidden_qty = level.hidden_qty;
+    levels_[i].order_count = level.order_count;
+}
+
+inline bool DepthCache::remove(lib::t_tick_index tick)
+{
+    std::size_t i = 0;
+    while (i < size_ && ticks_[i] != tick)
+        ++i;
+    if (i == size_)
+        return false;
+
+    for (--size_; i < size_; ++i)
+    {
+        ticks_[i] = ticks_[i + 1];
+        levels_[i] = levels_[i + 1];
+    }
+    return true;
+}
+
+inline std::size_t DepthCache::size() const
+{
+    return size_;
+}
+
+inline const DepthLevel* DepthCache::levels() const
+{
+    return levels_.data();
+}
+
+} // namespace lob
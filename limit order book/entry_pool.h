@@ -0,0 +1,132 @@
+/// @file entry_pool.h
+/// @brief This is a file to implement a fixed-size pool recycling the book entries of a limit order book.
+/// @author Shangwen Sun
+/// @date 04/28/2022
+
+#pragma once
+
+#include <cstdint>
+#include <new>
+
+#include "boost/noncopyable.hpp"
+
+#include "arena.h"
+#include "order_entry.h"
+
+namespace lob
+{
+
+/// @brief A fixed-size arena of book entries with a LIFO free list.
+///        Slots are handed out from the free list first, so the most recently released (still cached)
+///        slot is reused, and from the untouched tail of the arena otherwise. Nothing is allocated
+///        after construction; a free slot keeps the next free slot in its order_id field.
+///        The arena is an anonymous mapping and entries are constructed when first handed out,
+///        so an empty pool costs no page faults whatever its capacity.
+class EntryPool : public boost::noncopyable
+{
+public:
+    static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+    explicit EntryPool(std::size_t capacity, const lib::ArenaOptions& options = lib::ArenaOptions());
+
+    /// @brief take a slot out of the pool
+    /// @return the slot, or npos if every slot is in use
+    std::uint32_t allocate();
+
+    /// @brief give a slot back to the pool
+    void release(std::uint32_t slot);
+
+    /// @brief give the slot of an entry back to the pool
+    void release(const OrderBookEntry& entry);
+
+    /// @brief the entry in a slot
+    OrderBookEntry& operator[](std::uint32_t slot);
+
+    /// @brief the slot of an entry
+    std::uint32_t slot(const OrderBookEntry& entry) const;
+
+    /// @brief total number of slots
+    std::size_t capacity() const;
+
+    /// @brief number of slots in use
+    std::size_t in_use() const;
+
+    /// @brief the largest number of slots ever in use at once
+    std::size_t high_water_mark() const;
+
+    /// @brief bytes held by the arena
+    std::size_t memory_usage() const;
+
+private:
+    lib::MmapArena<OrderBookEntry> entries_;
+    std::uint32_t free_head_ = npos; // the most recently released slot
+    std::uint32_t untouched_ = 0; // slots at or above this index were never handed out
+    std::size_t in_use_ = 0;
+};
+
+inline EntryPool::EntryPool(std::size_t capacity, const lib::ArenaOptions& options) : entries_(capacity, options) {}
+
+inline std::uint32_t EntryPool::allocate()
+{
+    std::uint32_t slot;
+    if (free_head_ != npos)
+    {
+        slot = free_head_;
+        free_head_ = static_cast<std::uint32_t>(entries_[slot].order_id);
+    }
+    else if (untouched_ < entries_.size())
+    {
+        slot = untouched_++;
+        new (&entries_[slot]) OrderBookEntry();
+    }
+    else
+        return npos;
+
+    ++in_use_;
+    return slot;
+}
+
+inline void EntryPool::release(std::uint32_t slot)
+{
+    entries_[slot].order_id = free_head_;
+    free_head_ = slot;
+    --in_use_;
+}
+
+inline void EntryPool::release(const OrderBookEntry& entry)
+{
+    release(slot(entry));
+}
+
+inline OrderBookEntry& EntryPool::operator[](std::uint32_t slot)
+{
+    return entries_[slot];
+}
+
+inline std::uint32_t EntryPool::slot(const OrderBookEntry& entry) const
+{
+    return static_cast<std::uint32_t>(&entry - entries_.data());
+}
+
+inline std::size_t EntryPool::capacity() const
+{
+    return entries_.size();
+}
+
+inline std::size_t EntryPool::in_use() const
+{
+    return in_use_;
+}
+
+inline std::size_t EntryPool::high_water_mark() const
+{
+    // slots are only taken from the untouched tail when the free list is empty
+    return untouched_;
+}
+
+inline std::size_t EntryPool::memory_usage() const
+{
+    return entries_.bytes();
+}
+
+} // namespace lob
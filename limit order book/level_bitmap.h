@@ -0,0 +1,183 @@
+/// @file level_bitmap.h
+/// @brief This is a file to implement a hierarchical occupancy bitmap over the price levels of a limit order book.
+/// @author Shangwen Sun
+/// @date 04/26/2022
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace lob
+{
+
+/// @brief A three-level bitmap marking which price levels hold orders.
+///        Level 0 has one bit per price level, level 1 one bit per non-empty level-0 word and
+///        level 2 one bit per non-empty level-1 word, so the next (or previous) occupied level
+///        is found with a handful of ctz/clz instructions whatever the gap is.
+class LevelBitmap
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    LevelBitmap() = default;
+
+    /// @brief resize the bitmap to n positions, all cleared
+    void resize(std::size_t n);
+
+    /// @brief number of positions
+    std::size_t size() const;
+
+    /// @brief mark a position as occupied
+    void set(std::size_t pos);
+
+    /// @brief mark a position as empty
+    void reset(std::size_t pos);
+
+    /// @brief is the position occupied?
+    bool test(std::size_t pos) const;
+
+    /// @brief lowest occupied position at or above pos, or npos
+    std::size_t find_next(std::size_t pos) const;
+
+    /// @brief highest occupied position at or below pos, or npos
+    std::size_t find_prev(std::size_t pos) const;
+
+    /// @brief bytes held by the bitmap
+    std::size_t memory_usage() const;
+
+private:
+    static std::uint64_t mask_from(std::size_t pos) { return ~0ULL << (pos & 63); }
+    static std::uint64_t mask_upto(std::size_t pos) { return ~0ULL >> (63 - (pos & 63)); }
+    static std::size_t lowest(std::uint64_t bits) { return __builtin_ctzll(bits); }
+    static std::size_t highest(std::uint64_t bits) { return 63 - __builtin_clzll(bits); }
+
+private:
+    std::size_t size_ = 0;
+    std::vector<std::uint64_t> l0_;
+    std::vector<std::uint64_t> l1_;
+    std::vector<std::uint64_t> l2_;
+};
+
+inline void LevelBitmap::resize(std::size_t n)
+{
+    size_ = n;
+    l0_.assign((n + 63) >> 6, 0);
+    l1_.assign((l0_.size() + 63) >> 6, 0);
+    l2_.assign((l1_.size() + 63) >> 6, 0);
+}
+
+inline std::size_t LevelBitmap::size() const
+{
+    return size_;
+}
+
+inline void LevelBitmap::set(std::size_t pos)
+{
+    const std::size_t w = pos >> 6;
+    l0_[w] |= 1ULL << (pos & 63);
+    l1_[w >> 6] |= 1ULL << (w & 63);
+    l2_[w >> 12] |= 1ULL << ((w >> 6) & 63);
+}
+
+inline void LevelBitmap::reset(std::size_t pos)
+{
+    const std::size_t w = pos >> 6;
+    l0_[w] &= ~(1ULL << (pos & 63));
+    if (l0_[w])
+        return;
+    l1_[w >> 6] &= ~(1ULL << (w & 63));
+    if (l1_[w >> 6])
+        return;
+    l2_[w >> 12] &= ~(1ULL << ((w >> 6) & 63));
+}
+
+inline bool LevelBitmap::test(std::size_t pos) const
+{
+    return (l0_[pos >> 6] >> (pos & 63)) & 1ULL;
+}
+
+inline std::size_t LevelBitmap::find_next(std::size_t pos) const
+{
+    if (pos >= size_)
+        return npos;
+
+    // level 0: the rest of the word holding pos
+    std::size_t w = pos >> 6;
+    std::uint64_t bits = l0_[w] & mask_from(pos);
+    if (bits)
+        return (w << 6) | lowest(bits);
+
+    // level 1: the next non-empty level-0 word
+    const std::size_t p1 = w + 1;
+    if (p1 >= l0_.size())
+        return npos;
+    std::size_t w1 = p1 >> 6;
+    bits = l1_[w1] & mask_from(p1);
+    if (!bits)
+    {
+        // level 2: the next non-empty level-1 word
+        const std::size_t p2 = w1 + 1;
+        if (p2 >= l1_.size())
+            return npos;
+        std::size_t w2 = p2 >> 6;
+        bits = l2_[w2] & mask_from(p2);
+        while (!bits)
+        {
+            if (++w2 >= l2_.size())
+                return npos;
+            bits = l2_[w2];
+        }
+        w1 = (w2 << 6) | lowest(bits);
+        bits = l1_[w1];
+    }
+    w = (w1 << 6) | lowest(bits);
+    return (w << 6) | lowest(l0_[w]);
+}
+
+inline std::size_t LevelBitmap::find_prev(std::size_t pos) const
+{
+    if (size_ == 0)
+        return npos;
+    if (pos >= size_)
+        pos = size_ - 1;
+
+    // level 0: the beginning of the word holding pos
+    std::size_t w = pos >> 6;
+    std::uint64_t bits = l0_[w] & mask_upto(pos);
+    if (bits)
+        return (w << 6) | highest(bits);
+
+    // level 1: the previous non-empty level-0 word
+    if (w == 0)
+        return npos;
+    const std::size_t p1 = w - 1;
+    std::size_t w1 = p1 >> 6;
+    bits = l1_[w1] & mask_upto(p1);
+    if (!bits)
+    {
+        // level 2: the previous non-empty level-1 word
+        if (w1 == 0)
+            return npos;
+        const std::size_t p2 = w1 - 1;
+        std::size_t w2 = p2 >> 6;
+        bits = l2_[w2] & mask_upto(p2);
+        while (!bits)
+        {
+            if (w2 == 0)
+                return npos;
+            bits = l2_[--w2];
+        }
+        w1 = (w2 << 6) | highest(bits);
+        bits = l1_[w1];
+    }
+    w = (w1 << 6) | highest(bits);
+    return (w << 6) | highest(l0_[w]);
+}
+
+inline std::size_t LevelBitmap::memory_usage() const
+{
+    return (l0_.capacity() + l1_.capacity() + l2_.capacity()) * sizeof(std::uint64_t);
+}
+
+} // namespace lob
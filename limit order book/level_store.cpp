@@ -0,0 +1,107 @@
+//
+//  level_store.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 4/25/22.
+//
+
+#include <algorithm>
+
+#include "level_store.h"
+
+using namespace lob;
+
+bool LevelStore::grow(lib::t_tick_index tick)
+{
+    const lib::t_tick_index old_size = static_cast<lib::t_tick_index>(levels_.size());
+    const bool was_empty = occupied_.find_next(0) == LevelBitmap::npos;
+    lib::t_tick_index new_lo, new_hi;
+
+    if (was_empty && old_size != 0)
+    {
+        // no order rests in the window: slide it onto the order, its levels are empty and keep their storage
+        base_ = tick - old_size / 2;
+        adopt_outliers();
+        return true;
+    }
+
+    if (was_empty)
+    {
+        // the first order of the book: center the window on it, and set the outlier levels aside
+        outliers_.reserve(LEVEL_OUTLIER_MAX);
+        outlier_levels_.resize(LEVEL_OUTLIER_MAX);
+        free_outliers_.reserve(LEVEL_OUTLIER_MAX);
+        for (std::uint32_t slot = LEVEL_OUTLIER_MAX; slot-- > 0; )
+            free_outliers_.push_back(slot);
+        
+        new_lo = tick - LEVEL_WINDOW_MIN / 2;
+        new_hi = new_lo + LEVEL_WINDOW_MIN - 1;
+    }
+    else
+    {
+        new_lo = std::min(tick, lo());
+        new_hi = std::max(tick, hi());
+
+        // a level too far away from the orders in the window becomes an outlier
+        if (new_hi - new_lo + 1 > LEVEL_WINDOW_MAX)
+            return false;
+
+        // at least double the window on the side the book is moving to, so growth stays amortized O(1)
+        const lib::t_tick_index target = std::min<lib::t_tick_index>(2 * old_size, LEVEL_WINDOW_MAX);
+        if (new_hi - new_lo + 1 < target)
+        {
+            if (tick < lo())
+                new_lo = new_hi - target + 1;
+            else
+                new_hi = new_lo + target - 1;
+        }
+    }
+
+    std::vector<PriceLevel> levels(static_cast<std::size_t>(new_hi - new_lo + 1));
+    occupied_.resize(levels.size());
+
+    // relink the existing price levels into the new window and rebuild the occupancy bitmap
+    if (!was_empty)
+    {
+        const lib::t_tick_index shift = base_ - new_lo;
+        for (lib::t_tick_index i = 0; i < old_size; ++i)
+        {
+            levels[i + shift].swap(levels_[i]);
+            if (!levels[i + shift].empty())
+                occupied_.set(static_cast<std::size_t>(i + shift));
+        }
+    }
+
+    levels_.swap(levels);
+    base_ = new_lo;
+    adopt_outliers();
+    return true;
+}
+
+void LevelStore::adopt_outliers()
+{
+    const auto first = find_outlier(lo());
+    auto last = first;
+    for (; last != outliers_.end() && last->tick <= hi(); ++last)
+    {
+        levels_[last->tick - base_].swap(outlier_levels_[last->slot]);
+        occupied_.set(static_cast<std::size_t>(last->tick - base_));
+        free_outliers_.push_back(last->slot);
+    }
+    outliers_.erase(first, last);
+}
+
+PriceLevel* LevelStore::add_outlier(lib::t_tick_index tick)
+{
+    const auto outlier = find_outlier(tick);
+    if (outlier != outliers_.end() && outlier->tick == tick)
+        return &outlier_levels_[outlier->slot];
+    if (free_outliers_.empty())
+        return nullptr;
+    
+    // the table is reserved for every slot, so the insert only shifts the outliers above the tick
+    const std::uint32_t slot = free_outliers_.back();
+    free_outliers_.pop_back();
+    outliers_.insert(outlier, Outlier{tick, slot});
+    return &outlier_levels_[slot];
+}
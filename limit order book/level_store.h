@@ -0,0 +1,270 @@
+/// @file level_store.h
+/// @brief This is a file to implement a sparse, tick-indexed storage of the price levels of a limit order book.
+/// @author Shangwen Sun
+/// @date 04/25/2022
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include <utility>
+
+#include "boost/noncopyable.hpp"
+#include "boost/intrusive/list.hpp"
+
+#include "types.h"
+#include "order_entry.h"
+#include "level_bitmap.h"
+
+namespace lob
+{
+
+#define LEVEL_WINDOW_MIN 1024 // number of price levels allocated the first time a book is touched
+#define LEVEL_WINDOW_MAX (1 << 20) // the most price levels the window grows to, about 40 MB
+#define LEVEL_OUTLIER_MAX 256 // price levels a book keeps outside the window, preallocated with the window
+
+constexpr lib::t_tick_index NO_LEVEL_ABOVE = std::numeric_limits<lib::t_tick_index>::max(); // no occupied level above a tick index
+constexpr lib::t_tick_index NO_LEVEL_BELOW = std::numeric_limits<lib::t_tick_index>::min(); // no occupied level below a tick index
+
+typedef boost::intrusive::list<OrderBookEntry, boost::intrusive::constant_time_size<false> > pricePoint; // describes a single price point in the limit order book, doubly linked for O(1) cancel.
+
+/// @brief The resting orders at one price in time priority, with aggregates maintained on every add, fill and cancel.
+struct PriceLevel
+{
+    pricePoint orders;
+    lib::t_volume visible_qty = 0; // displayed quantity of the orders
+    lib::t_volume hidden_qty = 0; // undisplayed quantity of the iceberg orders
+    std::uint32_t order_count = 0; // number of orders
+    
+    bool empty() const { return orders.empty(); }
+    
+    void swap(PriceLevel& other)
+    {
+        orders.swap(other.orders);
+        std::swap(visible_qty, other.visible_qty);
+        std::swap(hidden_qty, other.hidden_qty);
+        std::swap(order_count, other.order_count);
+    }
+};
+
+/// @brief A contiguous window of price levels indexed by tick number.
+///        Only the tick range that has been touched by orders is allocated; the window grows
+///        (at least doubling) whenever an order arrives outside of it, up to LEVEL_WINDOW_MAX levels.
+///        A level the capped window can't reach, e.g. a limit order far away from the rest of the book,
+///        is kept in a flat table of outliers sorted by tick until it empties, so one far price costs a slot
+///        instead of the gap. The outlier levels are preallocated with the window, LEVEL_OUTLIER_MAX of them,
+///        so matching never allocates for them; a book whose table is full refuses a new far price.
+///        An occupancy bitmap over the window locates the next non-empty level without walking empty ones.
+class LevelStore : public boost::noncopyable
+{
+public:
+    LevelStore() = default;
+    ~LevelStore() = default;
+
+    /// @brief get the price level at a tick index, growing the window to cover it if needed
+    /// @return nullptr if the tick stays outside the window and the outlier table is full
+    PriceLevel* at(lib::t_tick_index tick);
+
+    /// @brief get the price level at a tick index which has one, see contains()
+    PriceLevel& operator[](lib::t_tick_index tick);
+    const PriceLevel& operator[](lib::t_tick_index tick) const;
+
+    /// @brief is there a price level at the tick index, in the window or among the outliers?
+    bool contains(lib::t_tick_index tick) const;
+
+    /// @brief is the tick index inside the allocated window?
+    bool in_window(lib::t_tick_index tick) const;
+
+    /// @brief lowest tick index of the window
+    lib::t_tick_index lo() const;
+
+    /// @brief highest tick index of the window
+    lib::t_tick_index hi() const;
+
+    /// @brief mark the price level at a tick index inside the window as holding orders
+    void set_occupied(lib::t_tick_index tick);
+
+    /// @brief mark the price level at a tick index as empty; an outlier level is released, so it must not be used after
+    void set_empty(lib::t_tick_index tick);
+
+    /// @brief lowest occupied tick index at or above tick, or NO_LEVEL_ABOVE
+    lib::t_tick_index next_occupied(lib::t_tick_index tick) const;
+
+    /// @brief highest occupied tick index at or below tick, or NO_LEVEL_BELOW
+    lib::t_tick_index prev_occupied(lib::t_tick_index tick) const;
+
+    /// @brief number of allocated price levels, in the window and outliers
+    std::size_t size() const;
+
+    /// @brief number of outlier price levels
+    std::size_t outlier_count() const;
+
+    /// @brief bytes held by the price levels
+    std::size_t memory_usage() const;
+
+private:
+    /// @brief widen the window to cover tick, unless that takes more than LEVEL_WINDOW_MAX levels; a window
+    ///        without orders is slid onto the tick instead, reusing its levels
+    /// @return false if the tick stays outside the window
+    bool grow(lib::t_tick_index tick);
+
+    /// @brief move the outlier levels the window covers now into it
+    void adopt_outliers();
+
+    /// @brief get the outlier level at a tick index, taking a free slot for it if it is new
+    /// @return nullptr if it is new and every slot is taken
+    PriceLevel* add_outlier(lib::t_tick_index tick);
+
+    /// @brief a level outside the window, by the slot of its price level
+    struct Outlier
+    {
+        lib::t_tick_index tick;
+        std::uint32_t slot;
+    };
+
+    /// @brief the first outlier at or above a tick index
+    std::vector<Outlier>::const_iterator find_outlier(lib::t_tick_index tick) const;
+
+private:
+    std::vector<PriceLevel> levels_;
+    LevelBitmap occupied_;
+    lib::t_tick_index base_ = 0; // tick index of levels_[0]
+    std::vector<Outlier> outliers_; // non-empty levels outside the window sorted by tick, never above LEVEL_OUTLIER_MAX
+    std::vector<PriceLevel> outlier_levels_; // the levels of the outliers, indexed by slot
+    std::vector<std::uint32_t> free_outliers_; // slots of outlier_levels_ no outlier holds
+};
+
+inline PriceLevel* LevelStore::at(lib::t_tick_index tick)
+{
+    if (in_window(tick) || grow(tick))
+        return &levels_[tick - base_];
+    return add_outlier(tick);
+}
+
+inline std::vector<LevelStore::Outlier>::const_iterator LevelStore::find_outlier(lib::t_tick_index tick) const
+{
+    return std::lower_bound(outliers_.begin(), outliers_.end(), tick,
+                            [](const Outlier& outlier, lib::t_tick_index t) { return outlier.tick < t; });
+}
+
+inline PriceLevel& LevelStore::operator[](lib::t_tick_index tick)
+{
+    return const_cast<PriceLevel&>(static_cast<const LevelStore&>(*this)[tick]);
+}
+
+inline const PriceLevel& LevelStore::operator[](lib::t_tick_index tick) const
+{
+    if (in_window(tick))
+        return levels_[tick - base_];
+    const auto outlier = find_outlier(tick);
+    assert(outlier != outliers_.end() && outlier->tick == tick && "no price level at the tick");
+    return outlier_levels_[outlier->slot];
+}
+
+inline bool LevelStore::contains(lib::t_tick_index tick) const
+{
+    if (in_window(tick))
+        return true;
+    const auto outlier = find_outlier(tick);
+    return outlier != outliers_.end() && outlier->tick == tick;
+}
+
+inline bool LevelStore::in_window(lib::t_tick_index tick) const
+{
+    return tick >= base_ && tick < base_ + static_cast<lib::t_tick_index>(levels_.size());
+}
+
+inline lib::t_tick_index LevelStore::lo() const
+{
+    return base_;
+}
+
+inline lib::t_tick_index LevelStore::hi() const
+{
+    return base_ + static_cast<lib::t_tick_index>(levels_.size()) - 1;
+}
+
+inline void LevelStore::set_occupied(lib::t_tick_index tick)
+{
+    // an outlier level is occupied for as long as it is in the table
+    if (in_window(tick))
+        occupied_.set(static_cast<std::size_t>(tick - base_));
+}
+
+inline void LevelStore::set_empty(lib::t_tick_index tick)
+{
+    if (in_window(tick))
+    {
+        occupied_.reset(static_cast<std::size_t>(tick - base_));
+        return;
+    }
+    
+    // the slot goes back to the free list with an empty level, ready for the next far price
+    const auto outlier = find_outlier(tick);
+    if (outlier == outliers_.end() || outlier->tick != tick)
+        return;
+    PriceLevel& level = outlier_levels_[outlier->slot];
+    level.visible_qty = level.hidden_qty = 0;
+    level.order_count = 0;
+    free_outliers_.push_back(outlier->slot);
+    outliers_.erase(outlier);
+}
+
+inline lib::t_tick_index LevelStore::next_occupied(lib::t_tick_index tick) const
+{
+    lib::t_tick_index next = NO_LEVEL_ABOVE;
+    if (tick <= hi())
+    {
+        const std::size_t pos = occupied_.find_next(tick < base_ ? 0 : static_cast<std::size_t>(tick - base_));
+        if (pos != LevelBitmap::npos)
+            next = base_ + static_cast<lib::t_tick_index>(pos);
+    }
+    if (!outliers_.empty())
+    {
+        const auto outlier = find_outlier(tick);
+        if (outlier != outliers_.end() && outlier->tick < next)
+            next = outlier->tick;
+    }
+    return next;
+}
+
+inline lib::t_tick_index LevelStore::prev_occupied(lib::t_tick_index tick) const
+{
+    lib::t_tick_index prev = NO_LEVEL_BELOW;
+    if (tick >= base_)
+    {
+        const std::size_t pos = occupied_.find_prev(static_cast<std::size_t>(tick - base_));
+        if (pos != LevelBitmap::npos)
+            prev = base_ + static_cast<lib::t_tick_index>(pos);
+    }
+    if (!outliers_.empty())
+    {
+        auto outlier = std::upper_bound(outliers_.begin(), outliers_.end(), tick,
+                                        [](lib::t_tick_index t, const Outlier& outlier) { return t < outlier.tick; });
+        if (outlier != outliers_.begin() && (--outlier)->tick > prev)
+            prev = outlier->tick;
+    }
+    return prev;
+}
+
+inline std::size_t LevelStore::size() const
+{
+    return levels_.size() + outliers_.size();
+}
+
+inline std::size_t LevelStore::outlier_count() const
+{
+    return outliers_.size();
+}
+
+inline std::size_t LevelStore::memory_usage() const
+{
+    return levels_.capacity() * sizeof(PriceLevel) + occupied_.memory_usage()
+         + outlier_levels_.capacity() * sizeof(PriceLevel) + outliers_.capacity() * sizeof(Outlier)
+         + free_outliers_.capacity() * sizeof(std::uint32_t);
+}
+
+} // namespace lob
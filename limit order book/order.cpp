@@ -9,17 +9,6 @@
 
 using namespace lob;
 
-/// @brief check if an input price satisfies tick size rule
-void is_valid_price(lib::TickSizeRule& tsr, lib::Price4 price)
-{
-    const auto ticks = tsr.GetTicks();
-    const auto tick_itr = std::lower_bound(ticks.cbegin(), ticks.cend(), price, [](const lib::Tick& lhs, lib::Price4 price){ return lhs.from_price < price;}) - 1;
-    const lib::t_tick tick_size = tick_itr->tick_size;
-    const lib::t_tick num_ticks = 1.0 * price.unscaled() / 10000 / tick_size;
-    if (std::abs(num_ticks - std::round(num_ticks)) > 1e-6)
-        throw std::invalid_argument("Order price doesn't match tick size rule!");
-}
-
 /// @brief a defualt constructor
 Order::Order(lib::t_time timestamp,
           lib::t_symbol symbol,
@@ -29,159 +18,186 @@ Order::Order(lib::t_time timestamp,
           lib::t_quantity qty,
           lib::OrderStatus status)
           : timestamp_(timestamp),
-            symbol_(symbol),
             order_id_(order_id),
-            is_buy_(is_buy),
-            price_(price),
+            symbol_(symbol),
             open_qty_(qty),
+            order_qty_(qty),
+            price_(price),
+            is_buy_(is_buy),
+            type_(price == MAX_PRICE || price == MIN_PRICE ? lib::OrderType::MARKET : lib::OrderType::LIMIT),
             status_(status) {}
 
+Order::Order(lib::t_time timestamp,
+          lib::t_symbol symbol,
+          lib::t_orderid order_id,
+          lib::t_side is_buy,
+          lib::t_price price,
+          lib::t_quantity display,
+          lib::t_quantity total,
+          lib::OrderStatus status)
+          : timestamp_(timestamp),
+            order_id_(order_id),
+            symbol_(symbol),
+            open_qty_(display),
+            order_qty_(total),
+            price_(price),
+            is_buy_(is_buy),
+            type_(lib::OrderType::ICEBERG),
+            status_(status),
+            condition_(lib::TimeInForce::DAY) {}
+
 Order::Order(lib::t_time timestamp,
              lib::t_orderid order_id) :
             timestamp_(timestamp),
             order_id_(order_id),
+            type_(lib::OrderType::UNKNOWN),
             status_(lib::OrderStatus::CANCEL) {}
 
 /// @brief construct an order by parsing a json object
 Order::Order(nlohmann::json& json_order, lib::TickSizeRule& tsr, lib::t_lot lot)
 {
+    from_json(json_order, tsr, lot);
+}
+
+void Order::from_json(nlohmann::json& json_order, lib::TickSizeRule& tsr, lib::t_lot lot)
+{
+    if (!json_order.is_object())
+        throw std::invalid_argument("Order is not a json object!");
+    
+    // collect the fields of the schema, then validate them like a decoded line
+    OrderFields fields;
+    fields.clear();
+    for (std::uint32_t bit = OrderFields::TIME; bit <= OrderFields::TOTAL; bit <<= 1)
+    {
+        const OrderFields::Field field = static_cast<OrderFields::Field>(bit);
+        const auto item = json_order.find(OrderFields::name(field));
+        if (item == json_order.end())
+            continue;
+        if (item->is_string())
+        {
+            const std::string& text = item->get_ref<const std::string&>();
+            fields.set_text(field, text.data(), text.size());
+        }
+        else if (item->is_number_integer())
+            fields.set_number(field, item->get<std::int64_t>());
+        else
+            fields.set_bad(field);
+    }
+    const RejectReason reason = from_fields(fields, tsr, lot);
+    if (reason != RejectReason::NONE)
+        throw std::invalid_argument(reject_reason_str(reason));
+}
+
+RejectReason lob::check_quantity(std::int64_t quantity, lib::t_lot lot)
+{
+    if (quantity <= 0 || quantity > std::numeric_limits<lib::t_quantity>::max())
+        return RejectReason::BAD_QUANTITY;
+    if (quantity % lot != 0)
+        return RejectReason::ODD_LOT;
+    return RejectReason::NONE;
+}
+
+RejectReason Order::from_fields(const OrderFields& fields, lib::TickSizeRule& tsr, lib::t_lot lot)
+{
+    // forget the previous order decoded into this one, keeping the symbol's buffer
+    symbol_.clear();
+    symbol_id_ = lib::NO_SYMBOL_ID;
+    open_qty_ = order_qty_ = 0;
+    price_ = 0;
+    is_buy_ = false;
+    type_ = lib::OrderType::UNKNOWN;
+    condition_ = lib::TimeInForce::UNKNOWN;
+    
     // parse order timestamp
-    timestamp_ = json_order.at("time");
+    if(!fields.has(OrderFields::TIME))
+        return RejectReason::MISSING_FIELD;
+    timestamp_ = fields.time;
     if(timestamp_ <= 0)
-        throw std::invalid_argument("Order has a bad timestamp information!");
+        return RejectReason::BAD_TIMESTAMP;
     
     // parse order id
-    order_id_ = json_order.at("order_id");
-    if(order_id_ <= 0)
-        throw std::invalid_argument("Order has a bad ID information!");
+    if(!fields.has(OrderFields::ORDER_ID))
+        return RejectReason::MISSING_FIELD;
+    if(fields.order_id <= 0)
+        return RejectReason::BAD_ORDER_ID;
+    order_id_ = fields.order_id;
     
     // parse order status
-    std::string load = json_order.at("type").get<std::string>();
-    if(load == "NEW")
+    if(!fields.has(OrderFields::TYPE))
+        return RejectReason::MISSING_FIELD;
+    if(fields.type == lib::OrderStatus::NEW)
         status_ = lib::OrderStatus::NEW;
-    else if(load == "CANCEL")
+    else if(fields.type == lib::OrderStatus::CANCEL)
     {
         status_ = lib::OrderStatus::CANCEL;
-        return; // if it is cancel order, there is no need to try parsing the other information, though the input order line still can contain some extra false informations
+        return RejectReason::NONE; // if it is cancel order, there is no need to try parsing the other information, though the input order line still can contain some extra false informations
     }
     else
-        throw std::invalid_argument("Order has a bad type information!");
-
-    
+        return RejectReason::BAD_TYPE;
     
     // parse order symbol
-    symbol_ = json_order.at("symbol").get<std::string>();
+    if(!fields.has(OrderFields::SYMBOL))
+        return RejectReason::MISSING_FIELD;
+    symbol_.assign(fields.symbol, fields.symbol_size);
     
+    // parse order side
+    if(!fields.has(OrderFields::SIDE))
+        return RejectReason::MISSING_FIELD;
+    if(fields.side == OrderFields::Side::UNKNOWN)
+        return RejectReason::BAD_SIDE;
+    is_buy_ = fields.side == OrderFields::Side::BUY;
     
-    // parse order type
-    try
+    // parse order type, if it is limit order, the order_type information might be omitted
+    type_ = fields.has(OrderFields::ORDER_TYPE) && fields.order_type != lib::OrderType::UNKNOWN ? fields.order_type : lib::OrderType::LIMIT;
+    RejectReason reason;
+    if(type_ == lib::OrderType::MARKET)
     {
-        load = json_order.at("order_type").get<std::string>();
-        if(load == "MARKET")
-        {
-            type_ = lib::OrderType::MARKET;
-            
-            // parse order quantity
-            order_qty_ = json_order.at("quantity");
-            if(order_qty_ <= 0)
-                throw std::invalid_argument("Market order has a bad quantity information!");
-            if(order_qty_ % lot != 0)
-                throw std::invalid_argument("Market order quantity is not round lot!");
-            
-            // parse order side
-            load = json_order.at("side").get<std::string>();
-            if(load == "BUY")
-            {
-                is_buy_ = true;
-                price_ = MAX_PRICE;
-            }
-            else if(load == "SELL")
-            {
-                is_buy_ = false;
-                price_ = MIN_PRICE;
-            }
-            else
-                throw std::invalid_argument("Order has a bad side information!");
-            
-            return;
-        }
-        else if(load == "LIMIT")
-            type_ = lib::OrderType::LIMIT;
-        else if(load == "ICEBERG")
-            type_ = lib::OrderType::ICEBERG;
-        else
-            throw std::invalid_argument("Order has a bad order_type information!");
-    }
-    catch(const std::exception& err)
-    {
-        type_ = lib::OrderType::LIMIT; // if it is limit order, the order_type information might be omitted
+        if(!fields.has(OrderFields::QUANTITY))
+            return RejectReason::MISSING_FIELD;
+        if((reason = check_quantity(fields.quantity, lot)) != RejectReason::NONE)
+            return reason;
+        order_qty_ = open_qty_ = static_cast<lib::t_quantity>(fields.quantity);
+        price_ = is_buy_ ? MAX_PRICE : MIN_PRICE;
+        return RejectReason::NONE;
     }
     
     // parse order price
-    load = json_order.at("limit_price").get<std::string>();
-    lib::Price4 price_obj(load);
-    is_valid_price(tsr, price_obj);
+    if(!fields.has(OrderFields::LIMIT_PRICE))
+        return RejectReason::MISSING_FIELD;
+    lib::Price4 price_obj;
+    if(!lib::Price4::parse(fields.limit_price, fields.limit_price + fields.limit_price_size, price_obj) || price_obj.unscaled() <= 0)
+        return RejectReason::BAD_PRICE;
+    if(!tsr.is_on_tick(price_obj.unscaled()))
+        return RejectReason::OFF_TICK;
     price_ = price_obj.unscaled();
-    if(price_ <= 0)
-        throw std::invalid_argument("Order has a bad limit price information!");
-
-    // parse order side
-    load = json_order.at("side").get<std::string>();
-    if(load == "BUY")
-        is_buy_ = 1;
-    else if(load == "SELL")
-        is_buy_ = 0;
-    else
-        throw std::invalid_argument("Order has a bad side information!");
-
-    // parse time-in-force
-    try
-    {
-        load = json_order.at("tif").get<std::string>();
-        if(load == "IOC")
-            condition_ = lib::TimeInForce::IOC;
-        else if(load == "GTC")
-            condition_ = lib::TimeInForce::GTC;
-        else if(load == "DAY")
-            condition_ = lib::TimeInForce::DAY;
-        else
-            throw std::invalid_argument("Order has a bad time-in-force information!");
-    }
-    catch(const std::exception& err)
-    {
-        condition_ = lib::TimeInForce::DAY; // if it is a DAY order, the tif information might be omitted
-    }
     
-    if(type_ == lib::OrderType::ICEBERG & condition_ == lib::TimeInForce::IOC)
-    {
-        throw std::invalid_argument("An iceberg order can not be an IOC order!");
-        return;
-    }
+    // parse time-in-force, if it is a DAY order, the tif information might be omitted
+    condition_ = fields.has(OrderFields::TIF) && fields.tif != lib::TimeInForce::UNKNOWN ? fields.tif : lib::TimeInForce::DAY;
     
+    if(type_ == lib::OrderType::ICEBERG && condition_ == lib::TimeInForce::IOC)
+        return RejectReason::ICEBERG_IOC;
     
     if(type_ == lib::OrderType::LIMIT)
     {
         // parse order quantity
-        order_qty_ = json_order.at("quantity");
-        if(order_qty_ <= 0)
-            throw std::invalid_argument("Order has a bad quantity information!");
-        if(order_qty_ % lot != 0)
-            throw std::invalid_argument("Order quantity is not round lot!");
-        return; // if it is limit order, the parsing finishes here
+        if(!fields.has(OrderFields::QUANTITY))
+            return RejectReason::MISSING_FIELD;
+        if((reason = check_quantity(fields.quantity, lot)) != RejectReason::NONE)
+            return reason;
+        order_qty_ = open_qty_ = static_cast<lib::t_quantity>(fields.quantity);
+        return RejectReason::NONE; // if it is limit order, the parsing finishes here
     }
-        
-    // if it is iceberg order, parse visible/hidden order size
-    open_qty_ = json_order.at("display");
-    if(open_qty_ <= 0)
-        throw std::invalid_argument("Iceberg order has a bad visible quantity information!");
-    if(open_qty_ % lot != 0)
-        throw std::invalid_argument("Iceberg order quantity is not round lot!");
     
-    order_qty_ = json_order.at("total");
-    if(order_qty_ <= 0)
-        throw std::invalid_argument("Iceberg order has a bad hidden quantity information!");
-    if(order_qty_ % lot != 0)
-        throw std::invalid_argument("Iceberg order hidden quantity is not round lot!");
+    // if it is iceberg order, parse visible/hidden order size
+    if(!fields.has(OrderFields::DISPLAY) || !fields.has(OrderFields::TOTAL))
+        return RejectReason::MISSING_FIELD;
+    if((reason = check_quantity(fields.display, lot)) != RejectReason::NONE || (reason = check_quantity(fields.total, lot)) != RejectReason::NONE)
+        return reason;
+    if(fields.display > fields.total)
+        return RejectReason::BAD_DISPLAY;
+    open_qty_ = static_cast<lib::t_quantity>(fields.display);
+    order_qty_ = static_cast<lib::t_quantity>(fields.total);
+    return RejectReason::NONE;
 }
 
 
@@ -196,7 +212,7 @@ void Order::to_json(nlohmann::json& j)
                             {"symbol", symbol_},
                             {"side", lib::sideStr[is_buy_]},
                             {"quantity", open_qty_},
-                            {"limit_price", std::to_string(1.0 * price_/10000)}};
+                            {"limit_price", lib::Price4(price_).to_str()}};
     }
     else
     {
@@ -16,6 +16,8 @@
 #include "price4.h"
 #include "types.h"
 #include "ticks.h"
+#include "order_decoder.h"
+#include "reject.h"
 
 
 namespace lob
@@ -24,6 +26,9 @@ namespace lob
 constexpr lib::t_price MAX_PRICE = std::numeric_limits<lib::t_price>::max();
 constexpr lib::t_price MIN_PRICE = 1;
 
+/// @brief check that a quantity is positive, fits a t_quantity and is a round lot
+RejectReason check_quantity(std::int64_t quantity, lib::t_lot lot);
+
 /// @brief implement an order type to be filled in the limit order book
 class Order
 {
@@ -36,10 +41,30 @@ public:
           lib::t_quantity qty,
           lib::OrderStatus status);
     
+    /// @brief construct an iceberg order showing `display` out of `total`
+    Order(lib::t_time timestamp,
+          lib::t_symbol symbol,
+          lib::t_orderid order_id,
+          lib::t_side is_buy,
+          lib::t_price price,
+          lib::t_quantity display,
+          lib::t_quantity total,
+          lib::OrderStatus status);
+    
     Order(lib::t_time timestamp, lib::t_orderid order_id);
+    
+    /// @brief construct an empty request, a placeholder to assign an order to
+    Order();
 
     Order(nlohmann::json& json_order, lib::TickSizeRule& tsr, lib::t_lot lot);
     
+    /// @brief decode a json order into this one, reusing its storage; throws std::invalid_argument naming the reject reason
+    void from_json(nlohmann::json& json_order, lib::TickSizeRule& tsr, lib::t_lot lot);
+    
+    /// @brief validate decoded order fields into this one, reusing its storage and applying the defaults of omitted fields
+    /// @return why the order is invalid, or RejectReason::NONE; nothing is thrown
+    RejectReason from_fields(const OrderFields& fields, lib::TickSizeRule& tsr, lib::t_lot lot);
+    
     lib::t_time timestamp() const;
     
     /// @brief get order id
@@ -50,11 +75,23 @@ public:
     
     /// @brief is this order a buy?
     bool is_buy() const;
+    
+    /// @brief get the order type: market, limit or iceberg
+    lib::OrderType order_type() const;
+    
+    /// @brief is this an iceberg order?
+    bool is_iceberg() const;
 
     /// @brief get the order's state
     const lib::OrderStatus& status() const;
     
-    lib::t_symbol symbol() const;
+    const lib::t_symbol& symbol() const;
+    
+    /// @brief get the interned id of the symbol, or NO_SYMBOL_ID before the order is routed
+    lib::t_symbol_id symbol_id() const;
+    
+    /// @brief set the interned id of the symbol
+    void set_symbol_id(lib::t_symbol_id symbol_id);
     
     /// @brief get the limit price of this order
     lib::t_price price() const;
@@ -90,22 +127,25 @@ public:
     void to_json(nlohmann::json& j);
 
 private:
-    lib::t_time timestamp_; // time the order arrives
-    lib::t_orderid order_id_;
+    lib::t_time timestamp_ = 0; // time the order arrives
+    lib::t_orderid order_id_ = 0;
     lib::t_symbol symbol_; // the instrument symbol (e.g. AAPL, TSLA)
-    lib::t_quantity open_qty_; // number of shares to display
-    lib::t_quantity order_qty_; // number of shares in total
-    lib::t_price price_; // price for limit order; 0 for market order
-    lib::t_side is_buy_; // 1 for buy, 0 for sell
+    lib::t_symbol_id symbol_id_ = lib::NO_SYMBOL_ID; // index of the symbol's order book in the engine
+    lib::t_quantity open_qty_ = 0; // number of shares to display
+    lib::t_quantity order_qty_ = 0; // number of shares in total
+    lib::t_price price_ = 0; // price for limit order; 0 for market order
+    lib::t_side is_buy_ = false; // 1 for buy, 0 for sell
     
-    lib::OrderType type_; // market, limit or iceberg
-    lib::OrderStatus status_; // new or cancel
+    lib::OrderType type_ = lib::OrderType::UNKNOWN; // market, limit or iceberg
+    lib::OrderStatus status_ = lib::OrderStatus::UNKNOWN; // new or cancel
     lib::TimeInForce condition_ = lib::TimeInForce::UNKNOWN; // DAY, IOC, GTC
 public:
     static lib::t_orderid self_assigned_id_; // a global unique order id assigned by exchange
 };
 
 
+inline Order::Order() : Order(0, 0) {}
+
 inline lib::t_time Order::timestamp() const
 {
     return timestamp_;
@@ -118,7 +158,8 @@ inline lib::t_orderid Order::orderid() const
 
 inline bool Order::is_limit() const
 {
-    return (price_ > 0 && price_ != MAX_PRICE);
+    // a market sell carries MIN_PRICE, which is a valid limit price, so tell them apart by type
+    return type_ != lib::OrderType::MARKET && price_ > 0 && price_ != MAX_PRICE;
 }
 
 
@@ -127,16 +168,36 @@ inline lib::t_side Order::is_buy() const
     return is_buy_;
 }
 
+inline lib::OrderType Order::order_type() const
+{
+    return type_;
+}
+
+inline bool Order::is_iceberg() const
+{
+    return type_ == lib::OrderType::ICEBERG;
+}
+
 inline const lib::OrderStatus& Order::status() const
 {
     return status_;
 }
 
-inline lib::t_symbol Order::symbol() const
+inline const lib::t_symbol& Order::symbol() const
 {
     return symbol_;
 }
 
+inline lib::t_symbol_id Order::symbol_id() const
+{
+    return symbol_id_;
+}
+
+inline void Order::set_symbol_id(lib::t_symbol_id symbol_id)
+{
+    symbol_id_ = symbol_id;
+}
+
 inline lib::t_price Order::price() const
 {
     return price_;
@@ -0,0 +1,425 @@
+//
+//  order_decoder.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/6/22.
+//
+
+#include <cctype>
+
+#include "order_decoder.h"
+
+using namespace lob;
+
+/// @brief does the text of a string equal a literal?
+template <std::size_t N>
+static bool equals(const char* text, std::size_t size, const char (&literal)[N])
+{
+    return size == N - 1 && std::memcmp(text, literal, N - 1) == 0;
+}
+
+const char* OrderFields::name(Field field)
+{
+    switch (field)
+    {
+        case TIME: return "time";
+        case TYPE: return "type";
+        case ORDER_ID: return "order_id";
+        case SYMBOL: return "symbol";
+        case SIDE: return "side";
+        case ORDER_TYPE: return "order_type";
+        case LIMIT_PRICE: return "limit_price";
+        case QUANTITY: return "quantity";
+        case TIF: return "tif";
+        case DISPLAY: return "display";
+        case TOTAL: return "total";
+    }
+    return "";
+}
+
+
+
+void OrderFields::set_number(Field field, std::int64_t value)
+{
+    present |= field;
+    bad &= ~field;
+    switch (field)
+    {
+        case TIME: time = value; break;
+        case ORDER_ID: order_id = value; break;
+        case QUANTITY: quantity = value; break;
+        case DISPLAY: display = value; break;
+        case TOTAL: total = value; break;
+        default: bad |= field; break; // a text field
+    }
+}
+
+
+
+void OrderFields::set_text(Field field, const char* text, std::size_t size)
+{
+    present |= field;
+    bad &= ~field;
+    switch (field)
+    {
+        case TYPE:
+            type = equals(text, size, "NEW") ? lib::OrderStatus::NEW
+                 : equals(text, size, "CANCEL") ? lib::OrderStatus::CANCEL
+                 : lib::OrderStatus::UNKNOWN;
+            break;
+        case SIDE:
+            side = equals(text, size, "BUY") ? Side::BUY
+                 : equals(text, size, "SELL") ? Side::SELL
+                 : Side::UNKNOWN;
+            break;
+        case ORDER_TYPE:
+            order_type = equals(text, size, "LIMIT") ? lib::OrderType::LIMIT
+                       : equals(text, size, "MARKET") ? lib::OrderType::MARKET
+                       : equals(text, size, "ICEBERG") ? lib::OrderType::ICEBERG
+                       : lib::OrderType::UNKNOWN;
+            break;
+        case TIF:
+            tif = equals(text, size, "DAY") ? lib::TimeInForce::DAY
+                : equals(text, size, "IOC") ? lib::TimeInForce::IOC
+                : equals(text, size, "GTC") ? lib::TimeInForce::GTC
+                : lib::TimeInForce::UNKNOWN;
+            break;
+        case SYMBOL:
+            if (size >= ORDER_SYMBOL_CAPACITY)
+            {
+                bad |= field;
+                break;
+            }
+            std::memcpy(symbol, text, size);
+            symbol_size = static_cast<std::uint8_t>(size);
+            break;
+        case LIMIT_PRICE:
+            if (size >= ORDER_PRICE_CAPACITY)
+            {
+                bad |= field;
+                break;
+            }
+            std::memcpy(limit_price, text, size);
+            limit_price[size] = '\0';
+            limit_price_size = static_cast<std::uint8_t>(size);
+            break;
+        default:
+            bad |= field; // a number field
+            break;
+    }
+}
+
+
+
+bool OrderDecoder::decode(const char* begin, const char* end, OrderFields& fields)
+{
+    begin_ = p_ = begin;
+    end_ = end;
+    fields.clear();
+
+    skip_space();
+    if (!expect('{'))
+        return false;
+    skip_space();
+    if (p_ < end_ && *p_ == '}')
+        ++p_;
+    else
+    {
+        for (;;)
+        {
+            skip_space();
+            if (p_ == end_ || *p_ != '"')
+                return fail("expected a key");
+
+            const char* key;
+            std::size_t key_size;
+            bool escaped;
+            if (!string(key, key_size, escaped))
+                return false;
+            skip_space();
+            if (!expect(':'))
+                return false;
+            skip_space();
+
+            // no key of the schema needs an escape, so an escaped key is an unknown one
+            if (escaped ? !skip_value() : !value(fields, key, key_size))
+                return false;
+
+            skip_space();
+            if (p_ < end_ && *p_ == ',')
+            {
+                ++p_;
+                continue;
+            }
+            if (!expect('}'))
+                return false;
+            break;
+        }
+    }
+
+    skip_space();
+    if (p_ != end_)
+        return fail("unexpected characters after the object");
+    return true;
+}
+
+
+
+bool OrderDecoder::fail(const char* message)
+{
+    error_ = message;
+    error_column_ = p_ - begin_ + 1;
+    return false;
+}
+
+
+
+void OrderDecoder::skip_space()
+{
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n'))
+        ++p_;
+}
+
+
+
+bool OrderDecoder::expect(char c)
+{
+    if (p_ == end_)
+        return fail("unexpected end of line");
+    if (*p_ != c)
+    {
+        switch (c)
+        {
+            case '{': return fail("expected '{'");
+            case '}': return fail("expected ',' or '}'");
+            case ':': return fail("expected ':'");
+            default: return fail("unexpected character");
+        }
+    }
+    ++p_;
+    return true;
+}
+
+
+
+bool OrderDecoder::string(const char*& text, std::size_t& size, bool& escaped)
+{
+    // p_ is on the opening quote
+    text = ++p_;
+    escaped = false;
+    for (;;)
+    {
+        const char* q = find_string_end(p_, end_);
+        if (q == end_)
+        {
+            p_ = end_;
+            return fail("unterminated string");
+        }
+        if (*q == '"')
+        {
+            size = q - text;
+            p_ = q + 1;
+            return true;
+        }
+        if (*q != '\\')
+        {
+            p_ = q;
+            return fail("control character in string");
+        }
+
+        escaped = true;
+        p_ = q + 1;
+        if (p_ == end_ || *p_ == '\0' || !std::strchr("\"\\/bfnrtu", *p_))
+            return fail("invalid escape");
+        if (*p_++ != 'u')
+            continue;
+        for (int i = 0; i < 4; ++i, ++p_)
+        {
+            if (p_ == end_ || !std::isxdigit(static_cast<unsigned char>(*p_)))
+                return fail("invalid unicode escape");
+        }
+    }
+}
+
+
+
+bool OrderDecoder::integer(std::int64_t& value, bool& is_integer)
+{
+    const bool negative = p_ < end_ && *p_ == '-';
+    if (negative)
+        ++p_;
+    if (p_ == end_ || *p_ < '0' || *p_ > '9')
+        return fail("expected a value");
+
+    if (*p_ == '0' && p_ + 1 < end_ && p_[1] >= '0' && p_[1] <= '9')
+        return fail("leading zero in a number");
+
+    std::uint64_t magnitude = 0;
+    int digits = 0;
+    is_integer = true;
+    for (; p_ < end_ && *p_ >= '0' && *p_ <= '9'; ++p_, ++digits)
+        magnitude = magnitude * 10 + (*p_ - '0');
+    if (digits > 18)
+        is_integer = false; // may have overflowed, no field of the schema needs that many digits
+
+    if (p_ < end_ && *p_ == '.')
+    {
+        is_integer = false;
+        ++p_;
+        if (p_ == end_ || *p_ < '0' || *p_ > '9')
+            return fail("expected a digit after '.'");
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9')
+            ++p_;
+    }
+    if (p_ < end_ && (*p_ == 'e' || *p_ == 'E'))
+    {
+        is_integer = false;
+        ++p_;
+        if (p_ < end_ && (*p_ == '+' || *p_ == '-'))
+            ++p_;
+        if (p_ == end_ || *p_ < '0' || *p_ > '9')
+            return fail("expected a digit in the exponent");
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9')
+            ++p_;
+    }
+
+    value = negative ? -static_cast<std::int64_t>(magnitude) : static_cast<std::int64_t>(magnitude);
+    return true;
+}
+
+
+
+bool OrderDecoder::skip_value()
+{
+    if (p_ == end_)
+        return fail("unexpected end of line");
+
+    const char* text;
+    std::size_t size;
+    bool escaped;
+    switch (*p_)
+    {
+        case '"':
+            return string(text, size, escaped);
+        case 't':
+        case 'f':
+        case 'n':
+        {
+            const char* literal = *p_ == 't' ? "true" : *p_ == 'f' ? "false" : "null";
+            const std::size_t length = std::strlen(literal);
+            if (static_cast<std::size_t>(end_ - p_) < length || std::memcmp(p_, literal, length) != 0)
+                return fail("unexpected literal");
+            p_ += length;
+            return true;
+        }
+        case '{':
+        case '[':
+        {
+            // nested values only occur in unknown keys, so only their brackets and strings are tracked
+            int depth = 0;
+            while (p_ < end_)
+            {
+                if (*p_ == '"')
+                {
+                    if (!string(text, size, escaped))
+                        return false;
+                    continue;
+                }
+                if (*p_ == '{' || *p_ == '[')
+                    ++depth;
+                else if (*p_ == '}' || *p_ == ']')
+                {
+                    if (--depth == 0)
+                    {
+                        ++p_;
+                        return true;
+                    }
+                }
+                ++p_;
+            }
+            return fail("unterminated object or array");
+        }
+        default:
+        {
+            std::int64_t number;
+            bool is_integer;
+            return integer(number, is_integer);
+        }
+    }
+}
+
+
+
+bool OrderDecoder::value(OrderFields& fields, const char* key, std::size_t key_size)
+{
+    // find the field of the key
+    OrderFields::Field field;
+    bool is_string;
+    switch (key_size)
+    {
+        case 3:
+            if (!equals(key, key_size, "tif")) return skip_value();
+            field = OrderFields::TIF; is_string = true; break;
+        case 4:
+            if (equals(key, key_size, "time")) { field = OrderFields::TIME; is_string = false; }
+            else if (equals(key, key_size, "type")) { field = OrderFields::TYPE; is_string = true; }
+            else if (equals(key, key_size, "side")) { field = OrderFields::SIDE; is_string = true; }
+            else return skip_value();
+            break;
+        case 5:
+            if (!equals(key, key_size, "total")) return skip_value();
+            field = OrderFields::TOTAL; is_string = false; break;
+        case 6:
+            if (!equals(key, key_size, "symbol")) return skip_value();
+            field = OrderFields::SYMBOL; is_string = true; break;
+        case 7:
+            if (!equals(key, key_size, "display")) return skip_value();
+            field = OrderFields::DISPLAY; is_string = false; break;
+        case 8:
+            if (equals(key, key_size, "order_id")) { field = OrderFields::ORDER_ID; is_string = false; }
+            else if (equals(key, key_size, "quantity")) { field = OrderFields::QUANTITY; is_string = false; }
+            else return skip_value();
+            break;
+        case 10:
+            if (!equals(key, key_size, "order_type")) return skip_value();
+            field = OrderFields::ORDER_TYPE; is_string = true; break;
+        case 11:
+            if (!equals(key, key_size, "limit_price")) return skip_value();
+            field = OrderFields::LIMIT_PRICE; is_string = true; break;
+        default:
+            return skip_value();
+    }
+
+    if (p_ == end_)
+        return fail("unexpected end of line");
+    const bool is_number = *p_ == '-' || (*p_ >= '0' && *p_ <= '9');
+    if (is_string ? *p_ != '"' : !is_number)
+    {
+        fields.set_bad(field); // a later duplicate key overrides an earlier one, also with a bad value
+        return skip_value();
+    }
+
+    if (!is_string)
+    {
+        std::int64_t number;
+        bool is_integer;
+        if (!integer(number, is_integer))
+            return false;
+        if (is_integer)
+            fields.set_number(field, number);
+        else
+            fields.set_bad(field);
+        return true;
+    }
+
+    const char* text;
+    std::size_t size;
+    bool escaped;
+    if (!string(text, size, escaped))
+        return false;
+    if (escaped)
+        fields.set_bad(field);
+    else
+        fields.set_text(field, text, size);
+    return true;
+}
@@ -0,0 +1,169 @@
+/// @file order_decoder.h
+/// @brief This is a file to implement a decoder of JSON order lines which knows the order schema and never allocates.
+/// @author Shangwen Sun
+/// @date 05/06/2022
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "types.h"
+
+namespace lob
+{
+
+#define ORDER_SYMBOL_CAPACITY 16 // bytes of a symbol, longer symbols are rejected
+#define ORDER_PRICE_CAPACITY 32 // bytes of a limit price text, longer prices are rejected
+
+/// @brief The fields of one order request, decoded but not validated yet.
+///        A plain struct, so it can sit in a reused buffer and be copied with memcpy.
+///        Text fields with a fixed set of values are stored as enums, UNKNOWN for any other text.
+struct OrderFields
+{
+    enum Field : std::uint32_t
+    {
+        TIME = 1 << 0,
+        TYPE = 1 << 1,
+        ORDER_ID = 1 << 2,
+        SYMBOL = 1 << 3,
+        SIDE = 1 << 4,
+        ORDER_TYPE = 1 << 5,
+        LIMIT_PRICE = 1 << 6,
+        QUANTITY = 1 << 7,
+        TIF = 1 << 8,
+        DISPLAY = 1 << 9,
+        TOTAL = 1 << 10,
+    };
+
+    enum class Side : std::uint8_t
+    {
+        UNKNOWN = 0,
+        BUY = 1,
+        SELL = 2,
+    };
+
+    std::uint32_t present; // fields found in the line
+    std::uint32_t bad; // fields found with a value of the wrong json type or too long
+
+    lib::t_time time;
+    std::int64_t order_id;
+    lib::OrderStatus type;
+    lib::OrderType order_type;
+    Side side;
+    lib::TimeInForce tif;
+    std::int64_t quantity;
+    std::int64_t display;
+    std::int64_t total;
+
+    char symbol[ORDER_SYMBOL_CAPACITY];
+    std::uint8_t symbol_size;
+    char limit_price[ORDER_PRICE_CAPACITY]; // zero terminated
+    std::uint8_t limit_price_size;
+
+    /// @brief forget every field
+    void clear();
+
+    /// @brief was the field found with a usable value?
+    bool has(Field field) const;
+
+    /// @brief store the value of a number field, a later value of the same field overrides it
+    void set_number(Field field, std::int64_t value);
+
+    /// @brief store the value of a text field, a later value of the same field overrides it
+    void set_text(Field field, const char* text, std::size_t size);
+
+    /// @brief mark a field as found with an unusable value
+    void set_bad(Field field);
+
+    /// @brief get the name of a field in the order schema
+    static const char* name(Field field);
+};
+
+/// @brief Decodes one JSON line of the order schema into OrderFields in a single pass over its bytes.
+///        Unknown keys are skipped, so the line must still be a well formed object; strings with escapes
+///        are only accepted in unknown keys. Failures leave a static message and the column, nothing is thrown.
+class OrderDecoder
+{
+public:
+    /// @brief decode the line [begin, end) into fields
+    /// @return false if the line is not a json object of the order schema, see error()
+    bool decode(const char* begin, const char* end, OrderFields& fields);
+
+    /// @brief why the last decode failed
+    const char* error() const;
+
+    /// @brief column of the last decode failure, from 1
+    std::size_t error_column() const;
+
+private:
+    bool fail(const char* message);
+    void skip_space();
+    bool expect(char c);
+    bool string(const char*& text, std::size_t& size, bool& escaped);
+    bool integer(std::int64_t& value, bool& is_integer);
+    bool skip_value();
+    bool value(OrderFields& fields, const char* key, std::size_t key_size);
+
+private:
+    const char* begin_ = nullptr;
+    const char* p_ = nullptr;
+    const char* end_ = nullptr;
+    const char* error_ = "";
+    std::size_t error_column_ = 0;
+};
+
+inline void OrderFields::clear()
+{
+    std::memset(this, 0, sizeof(OrderFields));
+}
+
+inline bool OrderFields::has(Field field) const
+{
+    return (present & field) && !(bad & field);
+}
+
+inline void OrderFields::set_bad(Field field)
+{
+    present |= field;
+    bad |= field;
+}
+
+inline const char* OrderDecoder::error() const
+{
+    return error_;
+}
+
+inline std::size_t OrderDecoder::error_column() const
+{
+    return error_column_;
+}
+
+/// @brief find the first quote, backslash or control character in [p, end), or end
+inline const char* find_string_end(const char* p, const char* end)
+{
+#if defined(__SSE2__)
+    // compare 16 bytes at a time, most string fields end within the first block
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                                             _mm_cmpeq_epi8(_mm_max_epu8(block, control), control)); // unsigned byte <= 0x1F
+        const int mask = _mm_movemask_epi8(special);
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) > 0x1F)
+        ++p;
+    return p;
+}
+
+} // namespace lob
@@ -11,11 +11,14 @@ namespace lob
 {
 
 
-struct OrderBookEntry : public boost::intrusive::slist_base_hook<>
+struct OrderBookEntry : public boost::intrusive::list_base_hook<>
 {
-    lib::t_quantity order_qty{0}; // total order quantity
+    lib::t_quantity order_qty{0}; // remaining order quantity, visible and hidden
     lib::t_quantity open_qty{0}; // visible order quantity
+    lib::t_quantity display_qty{0}; // size of each visible slice of an iceberg order
     lib::t_orderid order_id;
+    lib::t_tick_index tick{0}; // tick index of the price level the entry rests at
+    bool is_buy = false;
     bool is_gtc = false;
     bool is_iceberg = false;
     
@@ -1,12 +1,15 @@
 #include <stdio.h>
 
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 #include "nlohmann/json.hpp"
 
 #include "order.h"
 #include "order_generator.h"
+#include "wire.h"
 
 using namespace lob;
 
@@ -22,68 +25,91 @@ lib::t_price OrderGenerator::genPrice(lib::TickSizeRule& tsr)
 {
     const std::vector<lib::Tick>& ticks = tsr.GetTicks();
     
-    lib::t_price price = static_cast<lib::t_price>(m_distPrice(m_gen));
+    lib::t_price price = static_cast<lib::t_price>(m_distPrice(m_gen)) * PowScale4;
     
     for(auto tick : ticks)
     {
-        if(price * 10000 <= tick.to_price.unscaled())
+        if(price <= tick.to_price.unscaled())
         {
-            double price_adj = static_cast<lib::t_price>(m_distPrice(m_gen)) * tick.tick_size;
-            return (price + price_adj) * PowScale4;
+            // a whole number of ticks in Price4 units, a double times the tick size would truncate below the tick
+            price += static_cast<lib::t_price>(m_distPrice(m_gen)) * tick.tick_units();
+            break;
         }
     }
-    return price * PowScale4;
+    // the offset may carry the price into a band with a coarser tick, round it down onto that band's grid
+    return tsr.tick_to_price(tsr.price_to_tick(price));
 }
 
-OrderGenerator::OrderGenerator(lib::t_symbol symbol): m_symbol(symbol)
+OrderGenerator::OrderGenerator(lib::t_symbol symbol) : OrderGenerator(std::vector<lib::t_symbol>{symbol}, 0.0, "orders_" + symbol + ".json")
 {
-    m_fileName = "orders_" + m_symbol + ".json";
+}
 
+OrderGenerator::OrderGenerator(const std::vector<lib::t_symbol>& symbols, double zipf_exponent, const std::string& file_name,
+                               OrderFileFormat format)
+    : m_fileName(file_name), m_format(format), m_symbols(symbols)
+{
     m_gen = std::mt19937(rd());
     m_distReal = std::uniform_real_distribution<double>(0.0, 1.0);
     m_distQuantity = std::uniform_int_distribution<lib::t_quantity>(1, 100);
     m_distPrice = std::lognormal_distribution<double>(5.0, 0.1);
+    
+    std::vector<double> weights;
+    for (std::size_t k = 1; k <= m_symbols.size(); ++k)
+        weights.push_back(1.0 / std::pow(static_cast<double>(k), zipf_exponent));
+    m_distSymbol = std::discrete_distribution<std::size_t>(weights.begin(), weights.end());
 }
 
 
 lib::t_orderid OrderGenerator::genCancelOrderId()
 {
     // The cancel order id should be an uncancelled order id.
-    lib::t_orderid size_orderIds = m_orderIds.size();
-    m_distOrderId = std::uniform_int_distribution<lib::t_orderid>(0, size_orderIds - 1);
-    auto it = m_orderIds.begin();
-    std::advance(it, m_distOrderId(m_gen));
-    lib::t_orderid res = *it;
+    std::uniform_int_distribution<std::size_t> distIndex(0, m_orderIds.size() - 1);
+    const std::size_t index = distIndex(m_gen);
+    lib::t_orderid res = m_orderIds[index];
     
-    // Take out the cancelled id
-    m_orderIds.erase(it);
+    // Take out the cancelled id -> O(1)
+    m_orderIds[index] = m_orderIds.back();
+    m_orderIds.pop_back();
 
     return res;
 }
 
 void OrderGenerator::run(lib::TickSizeRule& tsr, lib::t_lot lot, std::size_t size)
 {
-    std::fstream f(m_fileName, std::ios::out);
-
+    std::unique_ptr<WireWriter> writer;
+    std::fstream f;
+    if (m_format == OrderFileFormat::WIRE)
+        writer.reset(new WireWriter(m_fileName));
+    else
+        f.open(m_fileName, std::ios::out);
+
+    const lib::t_time start = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    
     // For simplicity, generate one order per second
-    for (int i = 0; i < 1000; i++)
+    for (std::size_t i = 0; i < size; i++)
     {
         lib::OrderStatus orderStatus = genOrderStatus();
-        nlohmann::json j;
+        Order myOrder;
         if (m_orderIds.empty() || orderStatus == lib::OrderStatus::NEW)
         {
-            m_orderIds.insert(globalOrderId);
-            Order myOrder(duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() + i, m_symbol, globalOrderId++, genOrderSide(), genPrice(tsr), genQuantity(lot), orderStatus);
-            myOrder.to_json(j);
+            m_orderIds.push_back(globalOrderId);
+            myOrder = Order(start + i, genSymbol(), globalOrderId++, genOrderSide(), genPrice(tsr), genQuantity(lot), lib::OrderStatus::NEW);
         }
         else
+            myOrder = Order(start + i, genCancelOrderId());
+        
+        if (writer)
         {
-            Order myOrder(duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() + i, genCancelOrderId());
-            myOrder.to_json(j);
+            writer->write(myOrder);
+            continue;
         }
-        
+        nlohmann::json j;
+        myOrder.to_json(j);
         f << j << std::endl;
     }
+    
+    if (writer)
+        writer->close();
 }
 
 
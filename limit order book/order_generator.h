@@ -7,7 +7,7 @@
 
 #include <chrono>
 #include <random>
-#include <unordered_set>
+#include <vector>
 
 #include "types.h"
 #include "order.h"
@@ -16,8 +16,17 @@
 namespace lob
 {
 
+/// @brief the file format an OrderGenerator writes: json lines, or the binary order format of wire.h
+enum class OrderFileFormat
+{
+    JSON = 0,
+    WIRE = 1,
+};
+
 // The orderGenerator is used to generate orders but not required by this project.
 // It generates the orders and write into one single json file.
+// With several symbols, the symbol of each new order is drawn from a Zipf law: the k-th symbol gets weight 1 / k^s,
+// so a few symbols carry most of the flow like on a real exchange.
 class OrderGenerator
 {
 private:
@@ -29,26 +38,33 @@ private:
     static double cancelRatio;
 
     std::string m_fileName;
-    lib::t_symbol m_symbol;    // Only one symbol for now
+    OrderFileFormat m_format = OrderFileFormat::JSON;
+    std::vector<lib::t_symbol> m_symbols;
 
     std::random_device rd;
     std::mt19937 m_gen;
     std::uniform_real_distribution<double> m_distReal;
     std::uniform_int_distribution<lib::t_quantity> m_distQuantity;
     std::lognormal_distribution<double> m_distPrice;
-    std::uniform_int_distribution<lib::t_orderid> m_distOrderId;
-    std::unordered_set<lib::t_orderid> m_orderIds;
+    std::discrete_distribution<std::size_t> m_distSymbol;
+    std::vector<lib::t_orderid> m_orderIds; // ids of the orders which were not cancelled yet
 
     // Randomly generate: orderId (cancel), orderType, orderSide, quantity, and limit price
     lib::t_orderid genCancelOrderId();
     lib::OrderStatus genOrderStatus();
     lib::t_side genOrderSide();
+    const lib::t_symbol& genSymbol();
     lib::t_quantity genQuantity(lib::t_lot lot);
     lib::t_price genPrice(lib::TickSizeRule& tsr);
 
 public:
     OrderGenerator() = default;
     OrderGenerator(lib::t_symbol symbol);
+    
+    /// @brief generate orders over several symbols into file_name, the k-th symbol drawing a share proportional to 1 / k^zipf_exponent
+    OrderGenerator(const std::vector<lib::t_symbol>& symbols, double zipf_exponent, const std::string& file_name,
+                   OrderFileFormat format = OrderFileFormat::JSON);
+    
     void run(lib::TickSizeRule& tsr, lib::t_lot lot, std::size_t size);
 };
 
@@ -63,6 +79,11 @@ inline lib::t_side OrderGenerator::genOrderSide()
     return m_distReal(m_gen) < 0.5? 1 : 0;
 }
 
+inline const lib::t_symbol& OrderGenerator::genSymbol()
+{
+    return m_symbols[m_distSymbol(m_gen)];
+}
+
 inline lib::t_quantity OrderGenerator::genQuantity(lib::t_lot lot)
 {
     return m_distQuantity(m_gen) * lot;
@@ -0,0 +1,164 @@
+/// @file order_index.h
+/// @brief This is a file to implement a flat hash index from order id to the slot of its book entry.
+/// @author Shangwen Sun
+/// @date 04/27/2022
+
+#pragma once
+
+#include <cstdint>
+
+#include "boost/noncopyable.hpp"
+
+#include "types.h"
+#include "arena.h"
+
+namespace lob
+{
+
+#define ORDER_INDEX_MIN_CAPACITY 65536 // slots of a new index, must be a power of two
+
+/// @brief An open-addressing (linear probing) table from order id to a 32-bit slot.
+///        Order id 0 marks an empty bucket, so only positive order ids can be stored.
+///        Erase shifts the following entries back instead of leaving tombstones, so lookups
+///        never degrade with cancel-heavy flow. The table doubles when it is half full.
+///        Buckets live in an anonymous mapping whose zero pages are already empty buckets.
+class OrderIndex : public boost::noncopyable
+{
+public:
+    static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+    explicit OrderIndex(const lib::ArenaOptions& options = lib::ArenaOptions());
+
+    /// @brief make room for n order ids without rehashing
+    void reserve(std::size_t n);
+
+    /// @brief add or overwrite the slot of an order id
+    void insert(lib::t_orderid order_id, std::uint32_t slot);
+
+    /// @brief get the slot of an order id, or npos
+    std::uint32_t find(lib::t_orderid order_id) const;
+
+    /// @brief remove an order id
+    /// @return true if the order id was found
+    bool erase(lib::t_orderid order_id);
+
+    /// @brief number of order ids in the index
+    std::size_t size() const;
+
+    /// @brief bytes held by the index
+    std::size_t memory_usage() const;
+
+private:
+    struct Bucket
+    {
+        lib::t_orderid order_id;
+        std::uint32_t slot;
+    };
+
+    std::size_t home(lib::t_orderid order_id) const;
+    void rehash(std::size_t capacity);
+
+private:
+    lib::ArenaOptions options_;
+    lib::MmapArena<Bucket> buckets_;
+    std::size_t mask_;
+    std::size_t size_ = 0;
+    int shift_;
+};
+
+inline OrderIndex::OrderIndex(const lib::ArenaOptions& options) : options_(options), buckets_(0)
+{
+    rehash(ORDER_INDEX_MIN_CAPACITY);
+}
+
+inline std::size_t OrderIndex::home(lib::t_orderid order_id) const
+{
+    // Fibonacci hashing spreads the consecutive order ids of a session over the whole table
+    return static_cast<std::size_t>((order_id * 11400714819323198485ULL) >> shift_);
+}
+
+inline void OrderIndex::reserve(std::size_t n)
+{
+    std::size_t capacity = buckets_.size();
+    while (capacity < 2 * n)
+        capacity <<= 1;
+    if (capacity != buckets_.size())
+        rehash(capacity);
+}
+
+inline void OrderIndex::insert(lib::t_orderid order_id, std::uint32_t slot)
+{
+    if (2 * (size_ + 1) > buckets_.size())
+        rehash(buckets_.size() << 1);
+
+    std::size_t i = home(order_id);
+    while (buckets_[i].order_id != 0 && buckets_[i].order_id != order_id)
+        i = (i + 1) & mask_;
+
+    if (buckets_[i].order_id == 0)
+        ++size_;
+    buckets_[i] = Bucket{order_id, slot};
+}
+
+inline std::uint32_t OrderIndex::find(lib::t_orderid order_id) const
+{
+    for (std::size_t i = home(order_id); buckets_[i].order_id != 0; i = (i + 1) & mask_)
+    {
+        if (buckets_[i].order_id == order_id)
+            return buckets_[i].slot;
+    }
+    return npos;
+}
+
+inline bool OrderIndex::erase(lib::t_orderid order_id)
+{
+    std::size_t i = home(order_id);
+    while (buckets_[i].order_id != order_id)
+    {
+        if (buckets_[i].order_id == 0)
+            return false;
+        i = (i + 1) & mask_;
+    }
+
+    // backward shift deletion: pull later entries of the probe run into the hole
+    for (std::size_t j = (i + 1) & mask_; buckets_[j].order_id != 0; j = (j + 1) & mask_)
+    {
+        const std::size_t k = home(buckets_[j].order_id);
+        // move j into the hole at i unless its home lies cyclically in (i, j]
+        if (((j - k) & mask_) >= ((j - i) & mask_))
+        {
+            buckets_[i] = buckets_[j];
+            i = j;
+        }
+    }
+    buckets_[i].order_id = 0;
+    --size_;
+    return true;
+}
+
+inline std::size_t OrderIndex::size() const
+{
+    return size_;
+}
+
+inline std::size_t OrderIndex::memory_usage() const
+{
+    return buckets_.bytes();
+}
+
+inline void OrderIndex::rehash(std::size_t capacity)
+{
+    lib::MmapArena<Bucket> buckets(capacity, options_);
+    buckets.swap(buckets_);
+    mask_ = capacity - 1;
+    shift_ = 64 - __builtin_ctzll(capacity);
+    size_ = 0;
+
+    for (std::size_t i = 0; i < buckets.size(); ++i)
+    {
+        if (buckets[i].order_id != 0)
+            insert(buckets[i].order_id, buckets[i].slot);
+    }
+}
+
+} // namespace lob
@@ -5,53 +5,198 @@
 //  Created by Sun Shangwen on 4/8/22.
 //
 
+#include <cstring>
+
 #include "parser.h"
 
 using namespace lob;
 
 
 
-std::vector<lib::t_order> OrderParser::load(const lib::FILE& file_name, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_)
+void OrderParser::open(const lib::FILE& file_name)
 {
+    input_file_.close();
+    input_file_.clear();
+    input_file_.open(file_name, std::ifstream::in);
+    line_number_ = 0;
+    rejects_.clear();
     
-    std::string line;
-    nlohmann::json j;
-    
-    std::ifstream input_file(file_name, std::ifstream::in);
-    std::vector<lib::t_order> orders;
-    int cnt = 0; // count line numbers
-    
-    if (!input_file.is_open())
+    if (!input_file_.is_open())
     {
         std::cout << "FAILED TO OPEN " << file_name << ".\n";
         throw std::exception();
     }
-    
+}
+
+
+
+bool OrderParser::next(lib::t_order& order, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_)
+{
     // if comes across error (invalid order input or parsing errors)
-    // print error information and skip that line/object
-    while (std::getline(input_file, line))
+    // count it by reason and skip that line/object
+    while (std::getline(input_file_, line_))
     {
-        cnt += 1;
-        try
-        {
-            j = nlohmann::json::parse(line);
-            
-        }
-        catch(const std::exception& err)
+        line_number_ += 1;
+        const RejectReason reason = decoder_.decode(line_.data(), line_.data() + line_.size(), fields_)
+                                  ? order.from_fields(fields_, tick_size_rule_, lot_size_) // checks if the input arguments are valid
+                                  : RejectReason::SYNTAX_ERROR;
+        if (reason == RejectReason::NONE)
         {
-            std::cout << "LINE " << cnt << " : PARSING ERROR..." << err.what() << std::endl;
+            if (symbols_ && order.status() == lib::OrderStatus::NEW)
+                order.set_symbol_id(symbols_->intern(order.symbol()));
+            return true;
         }
+        rejects_.add(reason, line_number_);
+    }
+    return false;
+}
+
+
+
+void OrderParser::start_chunks(const lib::FILE& file_name, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_, std::size_t threads)
+{
+    mapped_file_.reset(new lib::MappedFile(file_name));
+    line_number_ = 0;
+    rejects_.clear();
+    chunk_count_ = (mapped_file_->size() + PARSER_CHUNK_BYTES - 1) / PARSER_CHUNK_BYTES;
+    consumed_ = 0;
+    next_to_parse_.store(0);
+    abort_.store(false);
+    
+    // two buffers per thread keep every thread busy while the calling thread hands on a chunk
+    chunks_.resize(2 * threads);
+    for (std::size_t i = 0; i < chunks_.size(); ++i)
+    {
+        if (!chunks_[i])
+            chunks_[i].reset(new Chunk());
+        chunks_[i]->ready.store(static_cast<std::size_t>(-1));
+        chunks_[i]->free_for.store(i);
+    }
+    
+    for (std::size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(&OrderParser::parse_chunks, this, std::ref(tick_size_rule_), lot_size_);
+}
+
+
+
+std::size_t OrderParser::chunk_begin(std::size_t k) const
+{
+    if (k == 0)
+        return 0;
+    if (k >= chunk_count_)
+        return mapped_file_->size();
+    
+    // a chunk starts after the first newline at or after its nominal start, the previous chunk ends there
+    const std::size_t from = k * PARSER_CHUNK_BYTES - 1;
+    const char* data = mapped_file_->data();
+    const void* newline = std::memchr(data + from, '\n', mapped_file_->size() - from);
+    return newline ? static_cast<const char*>(newline) - data + 1 : mapped_file_->size();
+}
+
+
+
+void OrderParser::parse_chunks(lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_)
+{
+    const char* data = mapped_file_->data();
+    OrderDecoder decoder;
+    OrderFields fields;
+    for (;;)
+    {
+        const std::size_t k = next_to_parse_.fetch_add(1);
+        if (k >= chunk_count_)
+            return;
         
-        try
+        Chunk& chunk = *chunks_[k % chunks_.size()];
+        while (chunk.free_for.load(std::memory_order_acquire) != k)
         {
-            lib::t_order order(j, tick_size_rule_, lot_size_); // parse the order and checks if the input arguments are valid
-            orders.emplace_back(order);
+            if (abort_.load(std::memory_order_relaxed))
+                return;
+            std::this_thread::yield();
         }
-        catch(const std::exception& err)
+        
+        chunk.count = 0;
+        chunk.lines = 0;
+        chunk.rejects.clear();
+        chunk.symbols.clear();
+        const char* p = data + chunk_begin(k);
+        const char* end = data + chunk_begin(k + 1);
+        while (p < end)
         {
-            std::cout << "LINE " << cnt << " : INVALID ORDER INPUT..." << err.what() << std::endl;
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            const char* line_end = newline ? newline : end;
+            chunk.lines += 1;
+            
+            if (chunk.count == chunk.orders.size())
+                chunk.orders.emplace_back();
+            const RejectReason reason = decoder.decode(p, line_end, fields)
+                                      ? chunk.orders[chunk.count].from_fields(fields, tick_size_rule_, lot_size_)
+                                      : RejectReason::SYNTAX_ERROR;
+            if (reason == RejectReason::NONE)
+            {
+                lib::t_order& order = chunk.orders[chunk.count];
+                if (symbols_ && order.status() == lib::OrderStatus::NEW)
+                    order.set_symbol_id(chunk.symbols.intern(order.symbol()));
+                ++chunk.count;
+            }
+            else
+                chunk.rejects.add(reason, chunk.lines);
+            p = line_end + 1;
         }
+        
+        chunk.ready.store(k, std::memory_order_release);
+    }
+}
+
+
+
+OrderParser::Chunk* OrderParser::next_chunk()
+{
+    if (consumed_ == chunk_count_)
+        return nullptr;
+    
+    Chunk& chunk = *chunks_[consumed_ % chunks_.size()];
+    while (chunk.ready.load(std::memory_order_acquire) != consumed_)
+        std::this_thread::yield();
+    return &chunk;
+}
+
+
+
+void OrderParser::resolve_symbols(Chunk& chunk)
+{
+    if (!symbols_)
+        return;
+    
+    // a chunk repeats few symbols, so the shared registry is looked up once per symbol instead of once per order
+    symbol_ids_.resize(chunk.symbols.size());
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < chunk.symbols.size(); ++symbol_id)
+        symbol_ids_[symbol_id] = symbols_->intern(chunk.symbols.name(symbol_id));
+    for (std::size_t i = 0; i < chunk.count; ++i)
+    {
+        lib::t_order& order = chunk.orders[i];
+        if (order.symbol_id() != lib::NO_SYMBOL_ID)
+            order.set_symbol_id(symbol_ids_[order.symbol_id()]);
     }
-    return orders;
 }
 
+
+
+void OrderParser::release_chunk()
+{
+    Chunk& chunk = *chunks_[consumed_ % chunks_.size()];
+    rejects_.merge(chunk.rejects, line_number_);
+    line_number_ += chunk.lines;
+    chunk.free_for.store(consumed_ + chunks_.size(), std::memory_order_release);
+    ++consumed_;
+}
+
+
+
+void OrderParser::stop_chunks()
+{
+    abort_.store(true);
+    for (auto& worker : workers_)
+        worker.join();
+    workers_.clear();
+    mapped_file_.reset();
+}
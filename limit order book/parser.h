@@ -5,23 +5,189 @@
 
 #pragma once
 
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "nlohmann/json.hpp"
+
 #include "types.h"
+#include "symbols.h"
 #include "ticks.h"
+#include "mapped_file.h"
+#include "order_decoder.h"
+#include "reject.h"
 #include "order.h"
 
 namespace lob
 {
 
+#define PARSER_CHUNK_BYTES (1 << 20) // bytes of a mapped file parsed as one chunk by a parser thread
+
+/// @brief Streams the orders of a request file one line at a time.
+///        Each order is decoded into an order the caller reuses, so memory stays constant in the file size
+///        and the first order can be matched as soon as its line is read. Lines are decoded by an OrderDecoder
+///        straight into order fields, without building a json document.
+///        With several threads the file is mapped and cut at newlines into chunks parsed in parallel; the calling
+///        thread hands the orders on chunk by chunk in file order. A bounded set of chunk buffers is recycled,
+///        so memory still doesn't grow with the file.
+///        Given a symbol registry, the parser resolves the symbol of each new order to its id, so routing the order
+///        only indexes tables by id; parser threads intern into a registry of their chunk, whose ids the calling
+///        thread maps to the shared registry once per chunk.
 class OrderParser
 {
 public:
     OrderParser() = default;
-    std::vector<lib::t_order> load(const lib::FILE& file_name, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_);
+    
+    /// @brief intern the symbol of every new order into `symbols` and set the order's symbol id,
+    ///        nullptr leaves the ids unresolved; the registry is only used on the calling thread
+    void set_symbols(lib::SymbolRegistry* symbols);
+    
+    /// @brief start reading a request file
+    void open(const lib::FILE& file_name);
+    
+    /// @brief decode the next valid order of the file into `order`, counting and skipping invalid lines
+    /// @return false once the file is exhausted
+    bool next(lib::t_order& order, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_);
+    
+    /// @brief hand every valid order of a file to handler(lib::t_order&), decoded into one reused order
+    /// @return the number of valid orders
+    template <class Handler>
+    std::size_t for_each(const lib::FILE& file_name, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_, Handler handler);
+    
+    /// @brief hand every valid order of a file to handler(lib::t_order&) in file order, parsing on `threads` threads
+    /// @return the number of valid orders
+    template <class Handler>
+    std::size_t for_each(const lib::FILE& file_name, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_, std::size_t threads, Handler handler);
+    
+    /// @brief number of lines read from the current file
+    std::size_t line_number() const;
+    
+    /// @brief number of lines of the current file which were not valid orders
+    std::size_t rejected() const;
+    
+    /// @brief the lines of the current file which were not valid orders, by reason
+    const RejectStats& reject_stats() const;
     
     ~OrderParser() = default;
+    
+private:
+    /// @brief a buffer a parser thread decodes one chunk into
+    struct Chunk
+    {
+        std::vector<lib::t_order> orders; // reused, the first `count` are valid
+        std::size_t count = 0;
+        std::size_t lines = 0;
+        RejectStats rejects; // lines numbered within the chunk
+        lib::SymbolRegistry symbols; // symbols of the chunk, the orders carry their ids in it
+        std::atomic<std::size_t> ready{static_cast<std::size_t>(-1)}; // the chunk decoded into the buffer
+        std::atomic<std::size_t> free_for{0}; // the chunk which may be decoded into the buffer next
+    };
+    
+    /// @brief map a file and start the parser threads
+    void start_chunks(const lib::FILE& file_name, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_, std::size_t threads);
+    
+    /// @brief wait for the next chunk in file order, nullptr after the last one
+    Chunk* next_chunk();
+    
+    /// @brief set the symbol ids of the orders of a chunk from its own registry to the shared one
+    void resolve_symbols(Chunk& chunk);
+    
+    /// @brief give the buffer of the current chunk back to the parser threads
+    void release_chunk();
+    
+    /// @brief join the parser threads and unmap the file
+    void stop_chunks();
+    
+    /// @brief offset of the first line starting in chunk k
+    std::size_t chunk_begin(std::size_t k) const;
+    
+    /// @brief the body of a parser thread
+    void parse_chunks(lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_);
+    
+private:
+    std::ifstream input_file_;
+    std::string line_; // reused line buffer
+    OrderDecoder decoder_;
+    OrderFields fields_; // reused decoded line
+    std::size_t line_number_ = 0;
+    RejectStats rejects_;
+    lib::SymbolRegistry* symbols_ = nullptr; // the registry symbol ids are resolved in, if any
+    std::vector<lib::t_symbol_id> symbol_ids_; // reused, the shared id of each symbol of the current chunk
+    
+    std::unique_ptr<lib::MappedFile> mapped_file_;
+    std::vector<std::unique_ptr<Chunk>> chunks_; // chunk k is decoded into chunks_[k % chunks_.size()]
+    std::vector<std::thread> workers_;
+    std::size_t chunk_count_ = 0;
+    std::size_t consumed_ = 0; // chunks handed on
+    std::atomic<std::size_t> next_to_parse_{0};
+    std::atomic<bool> abort_{false};
 };
 
-} // namespace lob
+template <class Handler>
+std::size_t OrderParser::for_each(const lib::FILE& file_name, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_, Handler handler)
+{
+    open(file_name);
+    
+    lib::t_order order;
+    std::size_t count = 0;
+    while (next(order, tick_size_rule_, lot_size_))
+    {
+        handler(order);
+        ++count;
+    }
+    return count;
+}
 
+template <class Handler>
+std::size_t OrderParser::for_each(const lib::FILE& file_name, lib::TickSizeRule& tick_size_rule_, lib::t_lot lot_size_, std::size_t threads, Handler handler)
+{
+    if (threads <= 1)
+        return for_each(file_name, tick_size_rule_, lot_size_, handler);
+    
+    start_chunks(file_name, tick_size_rule_, lot_size_, threads);
+    std::size_t count = 0;
+    try
+    {
+        while (Chunk* chunk = next_chunk())
+        {
+            resolve_symbols(*chunk);
+            for (std::size_t i = 0; i < chunk->count; ++i)
+                handler(chunk->orders[i]);
+            count += chunk->count;
+            release_chunk();
+        }
+    }
+    catch (...)
+    {
+        stop_chunks();
+        throw;
+    }
+    stop_chunks();
+    return count;
+}
+
+inline void OrderParser::set_symbols(lib::SymbolRegistry* symbols)
+{
+    symbols_ = symbols;
+}
+
+inline std::size_t OrderParser::line_number() const
+{
+    return line_number_;
+}
+
+inline std::size_t OrderParser::rejected() const
+{
+    return rejects_.total();
+}
+
+inline const RejectStats& OrderParser::reject_stats() const
+{
+    return rejects_;
+}
+
+} // namespace lob
@@ -0,0 +1,112 @@
+/// @file reject.h
+/// @brief This is a file to define why an order request is rejected and to count the rejects by reason.
+/// @author Shangwen Sun
+/// @date 05/07/2022
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+
+namespace lob
+{
+
+/// @brief Why an order request was not accepted, NONE for a valid order.
+enum class RejectReason : std::uint8_t
+{
+    NONE = 0,
+    SYNTAX_ERROR = 1, // the line is not a json object
+    MISSING_FIELD = 2, // a required field is absent or has the wrong json type
+    BAD_TIMESTAMP = 3,
+    BAD_ORDER_ID = 4,
+    BAD_TYPE = 5, // neither NEW nor CANCEL, or a binary order neither limit, market nor iceberg
+    BAD_SIDE = 6,
+    BAD_QUANTITY = 7, // a quantity, display or total which is not positive or too large
+    ODD_LOT = 8, // a quantity which is not a multiple of the lot size
+    BAD_PRICE = 9, // a limit price which is not a positive number
+    OFF_TICK = 10, // a limit price between two ticks of its band
+    ICEBERG_IOC = 11, // an iceberg order can't be immediate-or-cancel
+    UNKNOWN_CANCEL = 12, // a cancel of an order which doesn't rest in any book
+    DUPLICATE_ORDER_ID = 13, // a new order whose id is already resting
+    BOOK_FULL = 14, // the remainder of an order found no free entry or far price level in its book and was dropped
+    BAD_DISPLAY = 15, // an iceberg order showing more than its total quantity
+    BAD_SYMBOL_ID = 16, // a binary order whose symbol id is not in the symbol table of its file, or a new symbol no id is left for
+};
+
+constexpr std::size_t REJECT_REASON_COUNT = 17;
+
+/// @brief get the name of a reject reason
+inline const char* reject_reason_str(RejectReason reason)
+{
+    static const char* const names[REJECT_REASON_COUNT] = {
+        "NONE", "SYNTAX_ERROR", "MISSING_FIELD", "BAD_TIMESTAMP", "BAD_ORDER_ID", "BAD_TYPE", "BAD_SIDE",
+        "BAD_QUANTITY", "ODD_LOT", "BAD_PRICE", "OFF_TICK", "ICEBERG_IOC", "UNKNOWN_CANCEL",
+        "DUPLICATE_ORDER_ID", "BOOK_FULL", "BAD_DISPLAY", "BAD_SYMBOL_ID"};
+    return names[static_cast<std::size_t>(reason)];
+}
+
+/// @brief Number of rejected requests per reason, with the first line rejected for each, so noisy input
+///        costs a counter increment per line instead of a console write.
+struct RejectStats
+{
+    std::array<std::size_t, REJECT_REASON_COUNT> counts{};
+    std::array<std::size_t, REJECT_REASON_COUNT> first_line{}; // 0 if not known
+
+    /// @brief count a reject at a line of the request file, 0 if the line is not known
+    void add(RejectReason reason, std::size_t line = 0);
+
+    /// @brief add the counts of other rejects, whose lines come after ours and are numbered from line_offset + 1
+    void merge(const RejectStats& other, std::size_t line_offset = 0);
+
+    /// @brief number of rejects for any reason
+    std::size_t total() const;
+
+    void clear();
+
+    void to_json(nlohmann::json& j) const;
+};
+
+inline void RejectStats::add(RejectReason reason, std::size_t line)
+{
+    const std::size_t i = static_cast<std::size_t>(reason);
+    if (counts[i]++ == 0)
+        first_line[i] = line;
+}
+
+inline void RejectStats::merge(const RejectStats& other, std::size_t line_offset)
+{
+    for (std::size_t i = 0; i < REJECT_REASON_COUNT; ++i)
+    {
+        if (counts[i] == 0 && other.counts[i] != 0)
+            first_line[i] = other.first_line[i] != 0 ? other.first_line[i] + line_offset : 0;
+        counts[i] += other.counts[i];
+    }
+}
+
+inline std::size_t RejectStats::total() const
+{
+    std::size_t total = 0;
+    for (std::size_t count : counts)
+        total += count;
+    return total;
+}
+
+inline void RejectStats::clear()
+{
+    counts.fill(0);
+    first_line.fill(0);
+}
+
+inline void RejectStats::to_json(nlohmann::json& j) const
+{
+    j = nlohmann::json::object();
+    for (std::size_t i = 1; i < REJECT_REASON_COUNT; ++i)
+    {
+        if (counts[i] != 0)
+            j[reject_reason_str(static_cast<RejectReason>(i))] = nlohmann::json{{"count", counts[i]}, {"first_line", first_line[i]}};
+    }
+}
+
+} // namespace lob
@@ -0,0 +1,168 @@
+//
+//  wire.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/9/22.
+//
+
+#include <algorithm>
+#include <limits>
+#include <iostream>
+#include <stdexcept>
+
+#include "parser.h"
+#include "wire.h"
+
+using namespace lob;
+
+WireOrder WireOrder::from_order(const Order& order, lib::t_symbol_id symbol_id)
+{
+    WireOrder message;
+    std::memset(&message, 0, sizeof(WireOrder)); // no padding, but keep every byte of the file defined
+    message.order_id = order.orderid();
+    message.time = order.timestamp();
+    message.status = static_cast<std::uint8_t>(order.status());
+    if (order.status() == lib::OrderStatus::CANCEL)
+    {
+        message.symbol_id = lib::NO_SYMBOL_ID;
+        return message;
+    }
+
+    message.symbol_id = symbol_id;
+    message.type = static_cast<std::uint8_t>(order.order_type());
+    message.side = order.is_buy() ? 1 : 0;
+    // an order built in code may leave the time in force out, a json line without one is a DAY order
+    message.tif = static_cast<std::uint8_t>(order.conditions() == lib::TimeInForce::UNKNOWN ? lib::TimeInForce::DAY : order.conditions());
+    message.price = order.order_type() == lib::OrderType::MARKET ? 0 : order.price();
+    message.quantity = order.order_qty();
+    message.display = order.open_qty();
+    return message;
+}
+
+RejectReason WireOrder::check(const lib::TickSizeRule& tsr, lib::t_lot lot, std::size_t symbol_count) const
+{
+    if (order_id == 0 || order_id > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+        return RejectReason::BAD_ORDER_ID;
+    if (time <= 0)
+        return RejectReason::BAD_TIMESTAMP;
+    if (status_code() == lib::OrderStatus::CANCEL)
+        return RejectReason::NONE;
+    if (status_code() != lib::OrderStatus::NEW)
+        return RejectReason::BAD_TYPE;
+
+    if (symbol_id >= symbol_count)
+        return RejectReason::BAD_SYMBOL_ID;
+    if (side > 1)
+        return RejectReason::BAD_SIDE;
+    if (type != static_cast<std::uint8_t>(lib::OrderType::LIMIT) && type != static_cast<std::uint8_t>(lib::OrderType::MARKET) &&
+        type != static_cast<std::uint8_t>(lib::OrderType::ICEBERG))
+        return RejectReason::BAD_TYPE;
+
+    RejectReason reason;
+    if ((reason = check_quantity(quantity, lot)) != RejectReason::NONE || (reason = check_quantity(display, lot)) != RejectReason::NONE)
+        return reason;
+    if (display > quantity)
+        return RejectReason::BAD_DISPLAY;
+    // only an iceberg order hides part of its quantity
+    if (!is_iceberg() && display != quantity)
+        return RejectReason::BAD_QUANTITY;
+    if (!is_limit())
+        return RejectReason::NONE;
+
+    if (price <= 0)
+        return RejectReason::BAD_PRICE;
+    if (!tsr.is_on_tick(price))
+        return RejectReason::OFF_TICK;
+    if (is_iceberg() && static_cast<lib::TimeInForce>(tif) == lib::TimeInForce::IOC)
+        return RejectReason::ICEBERG_IOC;
+    return RejectReason::NONE;
+}
+
+
+
+WireWriter::WireWriter(const lib::FILE& file_name) : out_(file_name, std::ios::out | std::ios::binary | std::ios::trunc)
+{
+    if (!out_.is_open())
+    {
+        std::cout << "FAILED TO OPEN " << file_name << ".\n";
+        throw std::exception();
+    }
+
+    // a zero header until close, so a file left half written has no messages
+    const WireHeader header{};
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(WireHeader));
+}
+
+WireWriter::~WireWriter()
+{
+    if (out_.is_open())
+        close();
+}
+
+void WireWriter::write(const Order& order)
+{
+    lib::t_symbol_id symbol_id = lib::NO_SYMBOL_ID;
+    if (order.status() != lib::OrderStatus::CANCEL)
+        symbol_id = symbols_.intern(order.symbol());
+
+    const WireOrder message = WireOrder::from_order(order, symbol_id);
+    out_.write(reinterpret_cast<const char*>(&message), sizeof(WireOrder));
+    ++order_count_;
+}
+
+void WireWriter::close()
+{
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < symbols_.size(); ++symbol_id)
+    {
+        // the parser rejects symbols which don't fit, so each one keeps a terminating zero
+        WireSymbol entry{};
+        const lib::t_symbol& name = symbols_.name(symbol_id);
+        std::memcpy(entry.name, name.data(), std::min(name.size(), sizeof(entry.name) - 1));
+        out_.write(reinterpret_cast<const char*>(&entry), sizeof(WireSymbol));
+    }
+
+    WireHeader header{};
+    std::memcpy(header.magic, WIRE_MAGIC, sizeof(header.magic));
+    header.version = WIRE_VERSION;
+    header.message_size = sizeof(WireOrder);
+    header.order_count = order_count_;
+    header.symbol_count = static_cast<std::uint32_t>(symbols_.size());
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(WireHeader));
+    out_.close();
+}
+
+
+
+WireReader::WireReader(const lib::FILE& file_name) : file_(file_name)
+{
+    if (file_.size() < sizeof(WireHeader))
+        throw std::invalid_argument("Not a binary order file: " + file_name);
+
+    // the mapping is page aligned and the header is 32 bytes, so every message sits on an 8 byte boundary
+    const WireHeader* header = reinterpret_cast<const WireHeader*>(file_.data());
+    if (std::memcmp(header->magic, WIRE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != WIRE_VERSION ||
+        header->message_size != sizeof(WireOrder))
+        throw std::invalid_argument("Not a binary order file: " + file_name);
+
+    order_count_ = header->order_count;
+    symbol_count_ = header->symbol_count;
+    if ((file_.size() - sizeof(WireHeader)) / sizeof(WireOrder) < order_count_ ||
+        file_.size() != sizeof(WireHeader) + order_count_ * sizeof(WireOrder) + symbol_count_ * sizeof(WireSymbol))
+        throw std::invalid_argument("Binary order file of the wrong size: " + file_name);
+
+    orders_ = reinterpret_cast<const WireOrder*>(file_.data() + sizeof(WireHeader));
+    symbols_ = reinterpret_cast<const WireSymbol*>(file_.data() + sizeof(WireHeader) + order_count_ * sizeof(WireOrder));
+}
+
+
+
+RejectStats lob::json_to_wire(const lib::FILE& json_file_name, const lib::FILE& wire_file_name, lib::TickSizeRule& tsr, lib::t_lot lot)
+{
+    OrderParser parser;
+    WireWriter writer(wire_file_name);
+    parser.for_each(json_file_name, tsr, lot, [&writer](Order& order) { writer.write(order); });
+    writer.close();
+    return parser.reject_stats();
+}
@@ -0,0 +1,237 @@
+/// @file wire.h
+/// @brief This is a file to implement the fixed layout binary order format, its writer and its zero-copy reader.
+/// @author Shangwen Sun
+/// @date 05/09/2022
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+#include "boost/noncopyable.hpp"
+
+#include "types.h"
+#include "mapped_file.h"
+#include "symbols.h"
+
+#include "order.h"
+#include "reject.h"
+
+namespace lob
+{
+
+// The file is read in place, so its little endian fields are only valid on a little endian host
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the binary order format is little endian");
+
+#define WIRE_MAGIC "LOBWIRE1" // first 8 bytes of a binary order file
+#define WIRE_VERSION 1
+
+/// @brief One order request as a 40 byte message, like an ITCH/OUCH "add order".
+///        Prices are Price4 units, 0 for a market order; the symbol is an id into the symbol table of the file.
+///        A message is read in place from the mapped file and handed to OrderBook::add as it is.
+struct WireOrder
+{
+    std::uint64_t order_id;
+    std::int64_t time;
+    std::int64_t price; // limit price, 0 for a market order
+    std::uint32_t symbol_id; // NO_SYMBOL_ID for a cancel
+    std::int32_t quantity; // total quantity
+    std::int32_t display; // shown quantity, equal to quantity unless it is an iceberg order
+    std::uint8_t status; // lib::OrderStatus, NEW or CANCEL
+    std::uint8_t type; // lib::OrderType
+    std::uint8_t side; // 1 for buy, 0 for sell
+    std::uint8_t tif; // lib::TimeInForce
+
+    /// @brief encode a valid order, its symbol id already interned
+    static WireOrder from_order(const Order& order, lib::t_symbol_id symbol_id);
+
+    /// @brief check a message read from a file as the parser checks a json line, the file having symbol_count symbols
+    /// @return why the order is invalid, or RejectReason::NONE
+    RejectReason check(const lib::TickSizeRule& tsr, lib::t_lot lot, std::size_t symbol_count) const;
+
+    lib::t_orderid orderid() const;
+    lib::OrderStatus status_code() const;
+    lib::OrderType order_type() const;
+    bool is_buy() const;
+    bool is_iceberg() const;
+    bool is_limit() const;
+
+    /// @brief the limit price, or the price a market order crosses the whole book at
+    lib::t_price limit_price() const;
+    lib::t_quantity order_qty() const;
+    lib::t_quantity open_qty() const;
+    bool immediate_or_cancel() const;
+    bool good_till_cancel() const;
+};
+
+static_assert(sizeof(WireOrder) == 40, "a binary order is 40 bytes");
+static_assert(offsetof(WireOrder, symbol_id) == 24 && offsetof(WireOrder, status) == 36, "binary order fields moved");
+
+/// @brief One entry of the symbol table at the end of the file, zero padded.
+struct WireSymbol
+{
+    char name[ORDER_SYMBOL_CAPACITY];
+};
+
+/// @brief The first 32 bytes of a binary order file: the messages follow it, then the symbol table.
+struct WireHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t message_size; // sizeof(WireOrder)
+    std::uint64_t order_count;
+    std::uint32_t symbol_count;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(WireHeader) == 32, "the binary order header is 32 bytes");
+
+/// @brief Appends orders to a binary order file, interning their symbols as it goes.
+///        The symbol table and the message count are written on close, so an unclosed file reads as empty.
+class WireWriter : public boost::noncopyable
+{
+public:
+    explicit WireWriter(const lib::FILE& file_name);
+    ~WireWriter();
+
+    /// @brief append a valid order
+    void write(const Order& order);
+
+    /// @brief write the symbol table and the header, once every order was written
+    void close();
+
+    /// @brief number of orders written
+    std::size_t size() const;
+
+private:
+    std::ofstream out_;
+    lib::SymbolRegistry symbols_;
+    std::uint64_t order_count_ = 0;
+};
+
+/// @brief A binary order file mapped read-only, its messages handed out in place without copying or decoding.
+class WireReader : public boost::noncopyable
+{
+public:
+    /// @brief map a binary order file, throws std::invalid_argument if its header or size don't match the format
+    explicit WireReader(const lib::FILE& file_name);
+
+    /// @brief number of messages
+    std::size_t size() const;
+    const WireOrder& operator[](std::size_t i) const;
+    const WireOrder* begin() const;
+    const WireOrder* end() const;
+
+    /// @brief number of symbols in the symbol table
+    std::size_t symbol_count() const;
+
+    /// @brief get the symbol of a file symbol id
+    std::string_view symbol(lib::t_symbol_id symbol_id) const;
+
+private:
+    lib::MappedFile file_;
+    const WireOrder* orders_ = nullptr;
+    const WireSymbol* symbols_ = nullptr;
+    std::size_t order_count_ = 0;
+    std::size_t symbol_count_ = 0;
+};
+
+/// @brief convert a json lines request file to a binary order file, dropping the rejected lines
+/// @return the lines rejected, by reason
+RejectStats json_to_wire(const lib::FILE& json_file_name, const lib::FILE& wire_file_name, lib::TickSizeRule& tsr, lib::t_lot lot);
+
+inline lib::t_orderid WireOrder::orderid() const
+{
+    return order_id;
+}
+
+inline lib::OrderStatus WireOrder::status_code() const
+{
+    return static_cast<lib::OrderStatus>(status);
+}
+
+inline lib::OrderType WireOrder::order_type() const
+{
+    return static_cast<lib::OrderType>(type);
+}
+
+inline bool WireOrder::is_buy() const
+{
+    return side != 0;
+}
+
+inline bool WireOrder::is_iceberg() const
+{
+    return order_type() == lib::OrderType::ICEBERG;
+}
+
+inline bool WireOrder::is_limit() const
+{
+    return order_type() != lib::OrderType::MARKET;
+}
+
+inline lib::t_price WireOrder::limit_price() const
+{
+    return is_limit() ? price : is_buy() ? MAX_PRICE : MIN_PRICE;
+}
+
+inline lib::t_quantity WireOrder::order_qty() const
+{
+    return quantity;
+}
+
+inline lib::t_quantity WireOrder::open_qty() const
+{
+    return display;
+}
+
+inline bool WireOrder::immediate_or_cancel() const
+{
+    return static_cast<lib::TimeInForce>(tif) == lib::TimeInForce::IOC || !is_limit();
+}
+
+inline bool WireOrder::good_till_cancel() const
+{
+    return static_cast<lib::TimeInForce>(tif) == lib::TimeInForce::GTC;
+}
+
+inline std::size_t WireWriter::size() const
+{
+    return order_count_;
+}
+
+inline std::size_t WireReader::size() const
+{
+    return order_count_;
+}
+
+inline const WireOrder& WireReader::operator[](std::size_t i) const
+{
+    return orders_[i];
+}
+
+inline const WireOrder* WireReader::begin() const
+{
+    return orders_;
+}
+
+inline const WireOrder* WireReader::end() const
+{
+    return orders_ + order_count_;
+}
+
+inline std::size_t WireReader::symbol_count() const
+{
+    return symbol_count_;
+}
+
+inline std::string_view WireReader::symbol(lib::t_symbol_id symbol_id) const
+{
+    const char* name = symbols_[symbol_id].name;
+    return std::string_view(name, strnlen(name, ORDER_SYMBOL_CAPACITY));
+}
+
+} // namespace lob
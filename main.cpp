@@ -47,14 +47,24 @@
 
 #include "message.h"
 #include "notifier.h"
+#include "feed.h"
+
+#include "benchmark.h"
 
 #include "nlohmann/json.hpp"
 
 using namespace lib;
 using namespace lob;
 
-int main()
+int main(int argc, char* argv[])
 {
+    /// Checks: fail the process if a check of the book, engine or market data paths fails, see README.md;
+    /// the checks build (-DEXCHANGE_CHECKS) always runs them, adding the heap allocation checks
+#ifndef EXCHANGE_CHECKS
+    if (argc > 1 && std::string(argv[1]) == "--checks")
+#endif
+        return bench::run_checks() ? 0 : 1;
+    
     /*
 
     /// Test TickSizeRule -> test passed!
@@ -72,9 +82,8 @@ int main()
      
      
     /// Test OrderParser -> test passed!
-    std::vector<lob::Order> orders;
     lob::OrderParser parser;
-    orders = parser.load("orders.jsonl", tsr, 100);
+    parser.for_each("orders.jsonl", tsr, 100, [](lob::Order& order) { std::cout << order.orderid() << std::endl; });
         
     
     /// Test  LimitOrderBook -> test passed!
@@ -96,7 +105,53 @@ int main()
      
     /// Test Notifier -> test passed!
     notify::Notifier notifier;
-    std::cout << notifier.notify_trade(1314000, 100).dump();
+    std::cout << notifier.to_json(notifier.notify_trade(1314000, 100)).dump();
+    
+    
+    /// Benchmark next level lookup across wide gaps
+    bench::level_lookup(1000, 500);
+    bench::wide_gap_sweep(200, 500, 50);
+    
+    /// Benchmark fills per second of the matching loop
+    bench::fill_throughput(100000, 8, 20);
+    bench::iceberg_throughput(10000, 8, 20);
+    
+    /// Benchmark the cost of recording the book events into the market data feed
+    bench::listener_overhead(100000, 8, 20);
+    
+    /// Benchmark tick size checks and tick indexing over mixed price bands
+    bench::tick_lookup(1000000);
+    
+    /// Benchmark order book startup, lazy against prefaulted arenas
+    lib::ArenaOptions prefaulted;
+    prefaulted.prefault = true;
+    bench::book_startup(500, lib::ArenaOptions());
+    bench::book_startup(4, prefaulted);
+    
+    /// Benchmark the parse -> matching shards -> publish pipeline on a multi-symbol replay
+    bench::pipeline_replay("orders_AAPL.json", "config.json", 4, lib::WaitStrategy::YIELD);
+    
+    /// Benchmark static shards against work stealing on a skewed symbol mix
+    bench::zipf_replay(1000, 1000000, 1.1, 4, "config.json");
+    
+    /// Benchmark the streaming parser against the chunked parallel parser
+    bench::parse_throughput("orders_zipf.json", "config.json", 4);
+    
+    /// Benchmark the order decoder against json documents
+    bench::decode_throughput("orders_AAPL.json", "config.json", 10000);
+    bench::reject_throughput("config.json", 1000000);
+    
+    /// Benchmark json lines against the binary order format
+    bench::wire_throughput("orders_zipf.json", "config.json");
+    
+    /// Benchmark the json notifier against the binary market data feed
+    bench::feed_throughput(1000000);
+    
+    /// Benchmark the asynchronous publisher against writing on the matching thread
+    bench::publisher_throughput(10000000, 64);
+    
+    /// Benchmark exact price parsing and formatting
+    bench::price_codec(1000000);
     
      */
 
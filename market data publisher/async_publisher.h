@@ -0,0 +1,290 @@
+/// @file async_publisher.h
+/// @brief This is a file to implement an asynchronous publisher: the matching thread copies encoded events into
+///        a lock-free ring and a writer thread appends them to a file in large block aligned writev calls.
+/// @author Shangwen Sun
+/// @date 05/12/2022
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "boost/noncopyable.hpp"
+#include "nlohmann/json.hpp"
+
+#include "types.h"
+#include "arena.h"
+#include "spsc_ring.h"
+
+namespace notify
+{
+
+#define PUBLISHER_BLOCK_BYTES 4096 // writes are whole blocks, except the tail written by a flush
+
+/// @brief How the publisher buffers and when it writes.
+struct PublisherConfig
+{
+    std::size_t ring_bytes = 1 << 22; // bytes in flight between the publishing thread and the writer, rounded up to a power of two
+    std::size_t flush_bytes = 1 << 16; // the writer writes as soon as this many bytes wait
+    std::chrono::microseconds flush_interval{1000}; // and writes whatever waits once the oldest byte is this old
+    bool drop_when_full = false; // drop a record when the ring is full instead of waiting for the writer
+};
+
+/// @brief Counters of a publisher, the backpressure it saw and the writes it made.
+struct PublisherStats
+{
+    std::uint64_t published_records = 0; // records accepted into the ring
+    std::uint64_t published_bytes = 0;
+    std::uint64_t dropped_records = 0; // records dropped because the ring was full or too small for them
+    std::uint64_t dropped_bytes = 0;
+    std::uint64_t full_events = 0; // times a publish found the ring full
+    double stalled_seconds = 0; // time publishers waited for room in the ring
+    std::uint64_t max_fill_bytes = 0; // most bytes waiting in the ring at a publish
+    std::uint64_t writes = 0; // writev calls
+    std::uint64_t written_bytes = 0;
+
+    void to_json(nlohmann::json& j) const;
+};
+
+/// @brief Appends records to a file without the publishing thread ever touching it.
+///        publish() copies a record into a single producer, single consumer ring of bytes and returns; the writer
+///        thread hands the ring's contents to writev, two iovecs when they wrap, once flush_bytes are waiting or
+///        flush_interval has passed. A full ring is backpressure: the publisher waits for room, or drops the record
+///        if drop_when_full is set, and either is counted. Records are never split, so the file holds whole records.
+class AsyncPublisher : public boost::noncopyable
+{
+public:
+    /// @brief open a file to append to and start the writer thread
+    AsyncPublisher(const lib::FILE& file_name, const PublisherConfig& config = PublisherConfig());
+    ~AsyncPublisher();
+
+    /// @brief queue a record of size bytes, from one thread only
+    /// @return false if the record was dropped, a record larger than the ring always is; both are counted
+    bool publish(const void* record, std::size_t size);
+
+    /// @brief write every queued record, then end the writer thread and close the file
+    void stop();
+
+    /// @brief counters so far, from the publishing thread; the write counters are exact once stopped
+    PublisherStats stats() const;
+
+private:
+    void run();
+
+    /// @brief write the waiting bytes, only whole blocks of them unless all is set
+    void write_ready(bool all);
+
+private:
+    PublisherConfig config_;
+    int fd_ = -1;
+    lib::MmapArena<char> ring_;
+    std::size_t mask_;
+
+    alignas(lib::CACHE_LINE_SIZE) std::atomic<std::uint64_t> head_{0}; // next byte to write, written by the writer
+    std::uint64_t cached_head_ = 0; // the publisher's view of head_
+    std::uint64_t published_records_ = 0;
+    std::uint64_t dropped_records_ = 0;
+    std::uint64_t dropped_bytes_ = 0;
+    std::uint64_t full_events_ = 0;
+    std::uint64_t stalled_ns_ = 0;
+    std::uint64_t max_fill_bytes_ = 0;
+
+    alignas(lib::CACHE_LINE_SIZE) std::atomic<std::uint64_t> tail_{0}; // next byte to fill, written by the publisher
+    std::atomic<bool> stopping_{false};
+    std::uint64_t writes_ = 0;
+    std::uint64_t written_bytes_ = 0;
+    std::thread thread_;
+};
+
+inline void PublisherStats::to_json(nlohmann::json& j) const
+{
+    j["published_records"] = published_records;
+    j["published_bytes"] = published_bytes;
+    j["dropped_records"] = dropped_records;
+    j["dropped_bytes"] = dropped_bytes;
+    j["full_events"] = full_events;
+    j["stalled_seconds"] = stalled_seconds;
+    j["max_fill_bytes"] = max_fill_bytes;
+    j["writes"] = writes;
+    j["written_bytes"] = written_bytes;
+}
+
+/// @brief the smallest power of two holding size bytes, at least a block
+inline std::size_t publisher_ring_bytes(std::size_t size)
+{
+    std::size_t bytes = PUBLISHER_BLOCK_BYTES;
+    while (bytes < size)
+        bytes <<= 1;
+    return bytes;
+}
+
+inline AsyncPublisher::AsyncPublisher(const lib::FILE& file_name, const PublisherConfig& config)
+    : config_(config), ring_(publisher_ring_bytes(config.ring_bytes)), mask_(ring_.size() - 1)
+{
+    config_.flush_bytes = std::min(std::max<std::size_t>(config_.flush_bytes, 1), ring_.size() / 2);
+    fd_ = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        std::cout << "FAILED TO OPEN " << file_name << ".\n";
+        throw std::exception();
+    }
+    thread_ = std::thread(&AsyncPublisher::run, this);
+}
+
+inline AsyncPublisher::~AsyncPublisher()
+{
+    stop();
+}
+
+inline bool AsyncPublisher::publish(const void* record, std::size_t size)
+{
+    if (size > ring_.size())
+    {
+        // it can never fit, whatever the writer does: lost like a record dropped by a full ring
+        ++dropped_records_;
+        dropped_bytes_ += size;
+        return false;
+    }
+
+    const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail + size - cached_head_ > ring_.size())
+    {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail + size - cached_head_ > ring_.size())
+        {
+            // backpressure: the writer is a whole ring behind
+            ++full_events_;
+            if (config_.drop_when_full)
+            {
+                ++dropped_records_;
+                dropped_bytes_ += size;
+                return false;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            while (tail + size - (cached_head_ = head_.load(std::memory_order_acquire)) > ring_.size())
+                std::this_thread::yield();
+            stalled_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    // copy in, wrapping around the end of the ring
+    const std::size_t at = tail & mask_;
+    const std::size_t first = std::min(size, ring_.size() - at);
+    std::memcpy(ring_.data() + at, record, first);
+    std::memcpy(ring_.data(), static_cast<const char*>(record) + first, size - first);
+    tail_.store(tail + size, std::memory_order_release);
+
+    ++published_records_;
+    max_fill_bytes_ = std::max<std::uint64_t>(max_fill_bytes_, tail + size - cached_head_);
+    return true;
+}
+
+inline void AsyncPublisher::stop()
+{
+    if (!thread_.joinable())
+        return;
+    stopping_.store(true, std::memory_order_release);
+    thread_.join();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+inline PublisherStats AsyncPublisher::stats() const
+{
+    PublisherStats stats;
+    stats.published_records = published_records_;
+    stats.published_bytes = tail_.load(std::memory_order_relaxed);
+    stats.dropped_records = dropped_records_;
+    stats.dropped_bytes = dropped_bytes_;
+    stats.full_events = full_events_;
+    stats.stalled_seconds = stalled_ns_ * 1e-9;
+    stats.max_fill_bytes = max_fill_bytes_;
+    if (!thread_.joinable())
+    {
+        // the writer's own counters are only read once it has exited
+        stats.writes = writes_;
+        stats.written_bytes = written_bytes_;
+    }
+    else
+        stats.written_bytes = head_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+inline void AsyncPublisher::run()
+{
+    // the publisher never signals, the writer sleeps a fraction of the flush interval between polls
+    const auto poll = std::max(std::chrono::microseconds(10), config_.flush_interval / 4);
+    std::chrono::steady_clock::time_point oldest; // when the writer first saw the bytes now waiting, zero if none
+    
+    for (;;)
+    {
+        // read stopping_ first, so every record published before stop() is counted in ready
+        const bool stopping = stopping_.load(std::memory_order_acquire);
+        const std::uint64_t ready = tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed);
+        if (ready == 0)
+        {
+            if (stopping)
+                break;
+            oldest = std::chrono::steady_clock::time_point();
+            std::this_thread::sleep_for(poll);
+            continue;
+        }
+        
+        const auto now = std::chrono::steady_clock::now();
+        if (oldest == std::chrono::steady_clock::time_point())
+            oldest = now;
+        if (stopping || now - oldest >= config_.flush_interval)
+        {
+            write_ready(true);
+            oldest = std::chrono::steady_clock::time_point();
+        }
+        else if (ready >= config_.flush_bytes)
+            write_ready(false); // the bytes of a partial block keep waiting since oldest
+        else
+            std::this_thread::sleep_for(poll);
+    }
+}
+
+inline void AsyncPublisher::write_ready(bool all)
+{
+    std::uint64_t head = head_.load(std::memory_order_relaxed);
+    std::uint64_t ready = tail_.load(std::memory_order_acquire) - head;
+    if (!all)
+        ready -= ready % PUBLISHER_BLOCK_BYTES;
+
+    while (ready > 0)
+    {
+        // the waiting bytes, in two pieces when they wrap around the end of the ring
+        const std::size_t at = head & mask_;
+        const std::size_t first = std::min<std::uint64_t>(ready, ring_.size() - at);
+        iovec pieces[2] = {{ring_.data() + at, first}, {ring_.data(), static_cast<std::size_t>(ready - first)}};
+        const ssize_t written = ::writev(fd_, pieces, ready > first ? 2 : 1);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            std::cout << "FAILED TO WRITE MARKET DATA.\n";
+            head += ready; // drop what can't be written, so the publisher isn't stalled for good
+            head_.store(head, std::memory_order_release);
+            return;
+        }
+        ++writes_;
+        written_bytes_ += written;
+        head += written;
+        ready -= written;
+        // the bytes are in the kernel now, the publisher may reuse them
+        head_.store(head, std::memory_order_release);
+    }
+}
+
+} // namespace notify
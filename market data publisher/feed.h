@@ -0,0 +1,284 @@
+/// @file feed.h
+/// @brief This is a file to implement the binary market data feed: fixed size sequenced messages like ITCH,
+///        and an optional json rendering of them on a thread of its own.
+/// @author Shangwen Sun
+/// @date 05/10/2022
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "boost/noncopyable.hpp"
+#include "nlohmann/json.hpp"
+
+#include "types.h"
+#include "price4.h"
+#include "spsc_ring.h"
+
+namespace notify
+{
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the market data feed is little endian");
+
+#define FEED_BATCH_MESSAGES 4096 // messages an encoder buffers before it hands them to its sink
+
+/// @brief What happened to an order of the book, the message type byte of the feed.
+enum class FeedMessageType : char
+{
+    NONE = 0,
+    ADD = 'A', // an order rests at a price level
+    MODIFY = 'U', // the shown quantity of a resting order changed, e.g. an iceberg slice was replenished
+    DELETE = 'D', // a resting order left the book, cancelled or fully filled
+    TRADE = 'E', // a resting order was executed against an incoming one
+};
+
+/// @brief One market data event as a 48 byte message.
+///        Every message carries the order id and price level it is about, and the visible quantity of the level
+///        afterwards, so a consumer can keep a book by price level or by order without a snapshot.
+struct FeedMessage
+{
+    std::uint64_t sequence; // from 1, one past the previous message of the encoder
+    std::uint64_t order_id; // the resting order
+    std::int64_t price; // Price4 units
+    std::uint32_t symbol_id;
+    std::int32_t quantity; // ADD: shown quantity, MODIFY: new shown quantity, DELETE: 0, TRADE: executed quantity
+    std::int64_t level_qty; // visible quantity of the price level after the event
+    FeedMessageType type;
+    std::uint8_t side; // side of the resting order, 1 for buy, 0 for sell
+    std::uint8_t reserved[6]; // zero
+
+    void to_json(nlohmann::json& j) const;
+};
+
+static_assert(sizeof(FeedMessage) == 48 && offsetof(FeedMessage, type) == 40, "a feed message is 48 bytes");
+
+/// @brief get the name of a feed message type
+inline const char* feed_message_type_str(FeedMessageType type)
+{
+    switch (type)
+    {
+        case FeedMessageType::ADD: return "ADD";
+        case FeedMessageType::MODIFY: return "MODIFY";
+        case FeedMessageType::DELETE: return "DELETE";
+        case FeedMessageType::TRADE: return "TRADE";
+        default: return "UNKNOWN";
+    }
+}
+
+/// @brief Numbers market data events and packs them into a preallocated buffer of fixed size messages.
+///        A full buffer, or flush(), hands the batch to the sink; nothing is allocated per event.
+class FeedEncoder : public boost::noncopyable
+{
+public:
+    typedef std::function<void(const FeedMessage* messages, std::size_t count)> Sink;
+
+    explicit FeedEncoder(Sink sink, std::size_t batch_messages = FEED_BATCH_MESSAGES);
+    ~FeedEncoder();
+
+    /// @brief an order rests at a price level
+    /// @return the sequence number of the message
+    std::uint64_t add(lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+
+    /// @brief the shown quantity of a resting order changed to qty
+    std::uint64_t modify(lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+
+    /// @brief a resting order left the book
+    std::uint64_t remove(lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_volume level_qty);
+
+    /// @brief qty of a resting order was executed
+    std::uint64_t trade(lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+
+    /// @brief hand the buffered messages to the sink
+    void flush();
+
+    /// @brief sequence number of the last message, 0 before the first one
+    std::uint64_t sequence() const;
+
+private:
+    std::uint64_t encode(FeedMessageType type, lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy,
+                         lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+
+private:
+    Sink sink_;
+    std::vector<FeedMessage> buffer_; // sized and zeroed once, never grows
+    std::size_t size_ = 0;
+    std::uint64_t sequence_ = 0;
+};
+
+/// @brief A sink writing the binary messages to a file as they are, appending to what it holds.
+class FeedWriter : public boost::noncopyable
+{
+public:
+    explicit FeedWriter(const lib::FILE& file_name);
+
+    void write(const FeedMessage* messages, std::size_t count);
+
+private:
+    std::ofstream out_;
+};
+
+/// @brief A sink rendering the messages as json lines on a thread of its own, so the encoding thread only copies
+///        48 byte messages into a ring; it waits only when the renderer falls a whole ring behind.
+class FeedJsonRenderer : public boost::noncopyable
+{
+public:
+    FeedJsonRenderer(const lib::FILE& file_name, std::size_t ring_capacity = 1 << 16,
+                     lib::WaitStrategy wait_strategy = lib::WaitStrategy::YIELD);
+    ~FeedJsonRenderer();
+
+    void write(const FeedMessage* messages, std::size_t count);
+
+    /// @brief render what was written so far, then end the thread
+    void stop();
+
+private:
+    void run();
+
+private:
+    std::ofstream out_;
+    lib::SpscRing<FeedMessage> ring_;
+    std::thread thread_;
+};
+
+inline void FeedMessage::to_json(nlohmann::json& j) const
+{
+    j = nlohmann::json{{"sequence", sequence},
+                        {"type", feed_message_type_str(type)},
+                        {"symbol_id", symbol_id},
+                        {"order_id", order_id},
+                        {"side", lib::sideStr[side != 0]},
+                        {"price", lib::Price4(price).to_str()},
+                        {"quantity", quantity},
+                        {"level_quantity", level_qty}};
+}
+
+inline FeedEncoder::FeedEncoder(Sink sink, std::size_t batch_messages)
+    : sink_(std::move(sink)), buffer_(batch_messages == 0 ? 1 : batch_messages)
+{
+}
+
+inline FeedEncoder::~FeedEncoder()
+{
+    flush();
+}
+
+inline std::uint64_t FeedEncoder::encode(FeedMessageType type, lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy,
+                                         lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    FeedMessage& message = buffer_[size_];
+    message.sequence = ++sequence_;
+    message.order_id = order_id;
+    message.price = price;
+    message.symbol_id = symbol_id;
+    message.quantity = qty;
+    message.level_qty = level_qty;
+    message.type = type;
+    message.side = is_buy ? 1 : 0;
+    if (++size_ == buffer_.size())
+        flush();
+    return sequence_;
+}
+
+inline std::uint64_t FeedEncoder::add(lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    return encode(FeedMessageType::ADD, symbol_id, order_id, is_buy, price, qty, level_qty);
+}
+
+inline std::uint64_t FeedEncoder::modify(lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    return encode(FeedMessageType::MODIFY, symbol_id, order_id, is_buy, price, qty, level_qty);
+}
+
+inline std::uint64_t FeedEncoder::remove(lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_volume level_qty)
+{
+    return encode(FeedMessageType::DELETE, symbol_id, order_id, is_buy, price, 0, level_qty);
+}
+
+inline std::uint64_t FeedEncoder::trade(lib::t_symbol_id symbol_id, lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    return encode(FeedMessageType::TRADE, symbol_id, order_id, is_buy, price, qty, level_qty);
+}
+
+inline void FeedEncoder::flush()
+{
+    if (size_ == 0)
+        return;
+    if (sink_)
+        sink_(buffer_.data(), size_);
+    size_ = 0;
+}
+
+inline std::uint64_t FeedEncoder::sequence() const
+{
+    return sequence_;
+}
+
+inline FeedWriter::FeedWriter(const lib::FILE& file_name) : out_(file_name, std::ios::out | std::ios::binary | std::ios::app)
+{
+    if (!out_.is_open())
+    {
+        std::cout << "FAILED TO OPEN " << file_name << ".\n";
+        throw std::exception();
+    }
+}
+
+inline void FeedWriter::write(const FeedMessage* messages, std::size_t count)
+{
+    out_.write(reinterpret_cast<const char*>(messages), count * sizeof(FeedMessage));
+}
+
+inline FeedJsonRenderer::FeedJsonRenderer(const lib::FILE& file_name, std::size_t ring_capacity, lib::WaitStrategy wait_strategy)
+    : out_(file_name, std::ios::out | std::ios::app), ring_(ring_capacity, wait_strategy)
+{
+    if (!out_.is_open())
+    {
+        std::cout << "FAILED TO OPEN " << file_name << ".\n";
+        throw std::exception();
+    }
+    thread_ = std::thread(&FeedJsonRenderer::run, this);
+}
+
+inline FeedJsonRenderer::~FeedJsonRenderer()
+{
+    stop();
+}
+
+inline void FeedJsonRenderer::write(const FeedMessage* messages, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+        ring_.push(messages[i]);
+}
+
+inline void FeedJsonRenderer::stop()
+{
+    if (!thread_.joinable())
+        return;
+    FeedMessage end;
+    std::memset(&end, 0, sizeof(FeedMessage)); // type NONE ends the thread
+    ring_.push(end);
+    thread_.join();
+    out_.flush();
+}
+
+inline void FeedJsonRenderer::run()
+{
+    FeedMessage message;
+    nlohmann::json j;
+    for (;;)
+    {
+        ring_.pop(message);
+        if (message.type == FeedMessageType::NONE)
+            break;
+        message.to_json(j);
+        out_ << j << '\n';
+    }
+}
+
+} // namespace notify
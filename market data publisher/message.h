@@ -1,67 +1,174 @@
 #pragma once
 
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
 #include "nlohmann/json.hpp"
 
 #include "types.h"
+#include "price4.h"
 #include "book.h"
 #include "order_entry.h"
 
 namespace notify
 {
 
+enum class CallbackType : std::uint8_t
+{
+    UNKNOWN = 0, // a level change of a depth update
+    TRADE = 1,
+    DEPTH_UPDATE = 2,
+};
+
+enum class CallbackAction : std::uint8_t
+{
+    UNKNOWN = 0,
+    ADD = 1,
+    DELETE = 2,
+    MODIFY = 3,
+};
+
+/// @brief get the name of a callback type
+inline const char* callback_type_str(CallbackType type)
+{
+    switch (type)
+    {
+        case CallbackType::TRADE: return "TRADE";
+        case CallbackType::DEPTH_UPDATE: return "DEPTH_UPDATE";
+        default: return "UNKNOWN";
+    }
+}
+
+/// @brief get the name of a callback action
+inline const char* callback_action_str(CallbackAction action)
+{
+    switch (action)
+    {
+        case CallbackAction::ADD: return "ADD";
+        case CallbackAction::DELETE: return "DELETE";
+        case CallbackAction::MODIFY: return "MODIFY";
+        default: return "UNKNOWN";
+    }
+}
+
+/// @brief A run of level changes in the level buffer of a notifier batch, by index so the buffer may be reused.
+struct LevelSpan
+{
+    std::uint32_t first;
+    std::uint32_t count;
+};
+
+/// @brief A market data event: a trade, a depth update, or one level change of a depth update.
+///        A plain struct without strings or containers, so recording an event is a copy into a reused buffer;
+///        a depth update refers to its level changes by span instead of owning them.
 class Callback
 {
 public:
-    Callback();
-    
-    nlohmann::json to_json();
+    /// @brief render the event, looking its level changes up in the level buffer of its batch
+    nlohmann::json to_json(const Callback* levels) const;
     
+    /// @brief append the json text of the event to out, the same text as to_json(levels).dump() without building
+    ///        a document; nothing is allocated once out holds the longest line
+    void append_json(std::string& out, const Callback* levels) const;
+
 public:
-    std::string type_; // TRADE; DEPTH_UPDATE
-    std::string action_; // ADD; DELETE; MODIFY
+    CallbackType type_; // TRADE; DEPTH_UPDATE
+    CallbackAction action_; // ADD; DELETE; MODIFY
 
     lib::t_price price_;
     lib::t_quantity qty_;
-    
-    std::vector<Callback> bids;
-    std::vector<Callback> asks;
+
+    LevelSpan bids; // DEPTH_UPDATE only
+    LevelSpan asks;
 };
 
+static_assert(std::is_trivially_copyable<Callback>::value && std::is_standard_layout<Callback>::value, "a callback is a plain struct");
 
-inline Callback::Callback() : type_("UNKNOWN"), action_("UNKNOWN"), price_(0), qty_(0)
+/// @brief make a trade or a level change event
+inline Callback make_callback(CallbackType type, CallbackAction action, lib::t_price price, lib::t_quantity qty)
 {
-    bids.resize(0);
-    asks.resize(0);
+    Callback cb{};
+    cb.type_ = type;
+    cb.action_ = action;
+    cb.price_ = price;
+    cb.qty_ = qty;
+    return cb;
 }
 
-inline nlohmann::json Callback::to_json()
+inline nlohmann::json Callback::to_json(const Callback* levels) const
 {
     nlohmann::json j;
-    j["price"] = std::to_string(1.0 * price_/10000);
+    j["price"] = lib::Price4(price_).to_str();
     j["quantity"] = qty_;
-    
-    if(type_ == "UNKNOWN")
+
+    if(type_ == CallbackType::UNKNOWN)
     {
-        j["action"] = action_;
+        j["action"] = callback_action_str(action_);
         return j;
     }
-    
-    j["type"] = type_;
-    
-    if(type_ == "TRADE")
+
+    j["type"] = callback_type_str(type_);
+
+    if(type_ == CallbackType::TRADE)
         return j;
-    
+
     j["bid"] = nlohmann::json::array();
     j["ask"] = nlohmann::json::array();
-    
-    for(auto act : bids)
-        j["bid"].emplace_back(act.to_json());
-    
-    for(auto act : asks)
-        j["ask"].emplace_back(act.to_json());
-    
+
+    for(std::uint32_t i = bids.first; i < bids.first + bids.count; ++i)
+        j["bid"].emplace_back(levels[i].to_json(levels));
+
+    for(std::uint32_t i = asks.first; i < asks.first + asks.count; ++i)
+        j["ask"].emplace_back(levels[i].to_json(levels));
+
     return j;
 };
 
-} // namespace notify
+inline void Callback::append_json(std::string& out, const Callback* levels) const
+{
+    // keys in the order nlohmann::json sorts them
+    char text[lib::Price4::MAX_STR_SIZE];
+    if(type_ == CallbackType::DEPTH_UPDATE)
+    {
+        out += "{\"ask\":[";
+        for(std::uint32_t i = asks.first; i < asks.first + asks.count; ++i)
+        {
+            if(i != asks.first)
+                out += ',';
+            levels[i].append_json(out, levels);
+        }
+        out += "],\"bid\":[";
+        for(std::uint32_t i = bids.first; i < bids.first + bids.count; ++i)
+        {
+            if(i != bids.first)
+                out += ',';
+            levels[i].append_json(out, levels);
+        }
+        out += "],";
+    }
+    else if(type_ == CallbackType::UNKNOWN)
+    {
+        out += "{\"action\":\"";
+        out += callback_action_str(action_);
+        out += "\",";
+    }
+    else
+        out += '{';
+    
+    out += "\"price\":\"";
+    out.append(text, lib::Price4(price_).format(text));
+    out += "\",\"quantity\":";
+    out.append(text, std::to_chars(text, text + sizeof(text), qty_).ptr);
+    
+    if(type_ != CallbackType::UNKNOWN)
+    {
+        out += ",\"type\":\"";
+        out += callback_type_str(type_);
+        out += '"';
+    }
+    out += '}';
+}
 
+} // namespace notify
@@ -7,109 +7,185 @@
 #pragma once
 #include <iostream>
 #include <fstream>
+#include <memory>
 
 #include "nlohmann/json.hpp"
 
 #include "types.h"
 #include "message.h"
+#include "async_publisher.h"
 
 namespace notify
 {
 
 #define MAX_MESSAGE_NUM 10000
+#define MAX_LEVEL_CHANGE_NUM 10000 // level changes of the depth updates in a batch
 
+/// @brief Collects the market data events of a batch into buffers reserved up front, so recording an event
+///        never allocates; clear() keeps their capacity. A buffer never grows past what was reserved: an event
+///        which doesn't fit any more is counted as dropped instead, so a batch must be published and cleared before.
+///        publish() hands the batch as json lines to an AsyncPublisher, which appends them to the file on its own thread.
 class Notifier
 {
 private:
     std::string outfile_; // file path to store the json messages
+    std::unique_ptr<AsyncPublisher> publisher_; // appends to outfile_, none without a file
+    std::string line_; // a rendered message, reused
 
-    std::vector<Callback> bids;
+    std::vector<Callback> bids; // level changes since the last depth update
     std::vector<Callback> asks;
     
+    std::vector<Callback> levels; // level changes of the depth updates of the batch, referred to by span
     std::vector<Callback> messages;
     
+    Callback dropped_event_{}; // the last event which didn't fit, so it may still be rendered
+    std::size_t dropped_ = 0;
+    
+    /// @brief keep an event in a buffer if it has room, else count it as dropped
+    const Callback& record(std::vector<Callback>& buffer, const Callback& event);
+    
 public:
-    Notifier() = default;
-    Notifier(std::string file_name) : outfile_(file_name)
+    Notifier() : Notifier(std::string()) {}
+    Notifier(std::string file_name, const PublisherConfig& config = PublisherConfig()) : outfile_(file_name)
     {
+        if (!outfile_.empty())
+            publisher_.reset(new AsyncPublisher(outfile_, config));
+        bids.reserve(MAX_LEVEL_CHANGE_NUM);
+        asks.reserve(MAX_LEVEL_CHANGE_NUM);
+        levels.reserve(MAX_LEVEL_CHANGE_NUM);
         messages.reserve(MAX_MESSAGE_NUM);
     };
     
     ~Notifier() = default;
     
     /// @brief create a new trade callback
-    nlohmann::json notify_trade(lib::t_price price, lib::t_quantity qty);
+    const Callback& notify_trade(lib::t_price price, lib::t_quantity qty);
     
     /// @brief create a new fill/delete/modify callback regarding bid side
-    nlohmann::json update_bid(std::string action, lib::t_price price, lib::t_quantity qty);
+    const Callback& update_bid(CallbackAction action, lib::t_price price, lib::t_quantity qty);
     
     /// @brief create a new fill/delete/modify callback regarding ask side
-    nlohmann::json update_ask(std::string action, lib::t_price price, lib::t_quantity qty);
+    const Callback& update_ask(CallbackAction action, lib::t_price price, lib::t_quantity qty);
 
-    nlohmann::json notify_update();
+    /// @brief create a depth update of the level changes since the last one;
+    ///        it is dropped with its level changes if they don't fit in the batch
+    const Callback& notify_update();
+    
+    /// @brief the events of the batch
+    const std::vector<Callback>& get_messages() const;
+    
+    /// @brief render an event of the batch
+    nlohmann::json to_json(const Callback& message) const;
+    
+    /// @brief append the json text of an event of the batch to out, as to_json(message).dump() without a document
+    void append_json(std::string& out, const Callback& message) const;
     
+    /// @brief queue the json lines of the batch's messages for the file, without waiting for the write
     void publish();
     
+    /// @brief backpressure and write counters of the file
+    PublisherStats publisher_stats() const;
+    
+    /// @brief events which didn't fit in their batch, since the notifier was created
+    std::size_t dropped() const;
+    
     void clear();
 };
 
-inline nlohmann::json Notifier::notify_trade(lib::t_price price, lib::t_quantity qty)
+inline const Callback& Notifier::record(std::vector<Callback>& buffer, const Callback& event)
 {
-    Callback cb;
-    cb.type_ = "TRADE";
-    cb.price_ = price;
-    cb.qty_ = qty;
-    
-    messages.emplace_back(cb);
-    return cb.to_json();
+    if (buffer.size() == buffer.capacity())
+    {
+        ++dropped_;
+        dropped_event_ = event;
+        return dropped_event_;
+    }
+    buffer.push_back(event);
+    return buffer.back();
 }
 
-inline nlohmann::json Notifier::update_bid(std::string action, lib::t_price price, lib::t_quantity qty)
+inline const Callback& Notifier::notify_trade(lib::t_price price, lib::t_quantity qty)
 {
-    Callback cb;
-    cb.action_ = action;
-    cb.price_ = price;
-    cb.qty_ = qty;
-    
-    bids.emplace_back(cb);
-    return cb.to_json();
+    return record(messages, make_callback(CallbackType::TRADE, CallbackAction::UNKNOWN, price, qty));
+}
+
+inline const Callback& Notifier::update_bid(CallbackAction action, lib::t_price price, lib::t_quantity qty)
+{
+    return record(bids, make_callback(CallbackType::UNKNOWN, action, price, qty));
 }
 
-inline nlohmann::json Notifier::update_ask(std::string action, lib::t_price price, lib::t_quantity qty)
+inline const Callback& Notifier::update_ask(CallbackAction action, lib::t_price price, lib::t_quantity qty)
+{
+    return record(asks, make_callback(CallbackType::UNKNOWN, action, price, qty));
+}
+
+
+inline const Callback& Notifier::notify_update()
 {
-    Callback cb;
-    cb.action_ = action;
-    cb.price_ = price;
-    cb.qty_ = qty;
+    // the level changes move into the batch's level buffer, the update only keeps where they are
+    Callback cb = make_callback(CallbackType::DEPTH_UPDATE, CallbackAction::UNKNOWN, 0, 0);
+    const bool fits = levels.size() + bids.size() + asks.size() <= levels.capacity() && messages.size() < messages.capacity();
+    if (fits)
+    {
+        cb.bids = LevelSpan{static_cast<std::uint32_t>(levels.size()), static_cast<std::uint32_t>(bids.size())};
+        levels.insert(levels.end(), bids.begin(), bids.end());
+        cb.asks = LevelSpan{static_cast<std::uint32_t>(levels.size()), static_cast<std::uint32_t>(asks.size())};
+        levels.insert(levels.end(), asks.begin(), asks.end());
+    }
+    else
+        dropped_ += bids.size() + asks.size();
+    bids.clear();
+    asks.clear();
     
-    asks.emplace_back(cb);
-    return cb.to_json();
+    return record(messages, cb);
+}
+
+inline const std::vector<Callback>& Notifier::get_messages() const
+{
+    return messages;
 }
 
+inline nlohmann::json Notifier::to_json(const Callback& message) const
+{
+    return message.to_json(levels.data());
+}
 
-inline nlohmann::json Notifier::notify_update()
+inline void Notifier::append_json(std::string& out, const Callback& message) const
 {
-    Callback cb;
-    cb.type_ = "DEPTH_UPDATE";
-    cb.bids = bids;
-    cb.asks = asks;
-    messages.emplace_back(cb);
-    return cb.to_json();
+    message.append_json(out, levels.data());
 }
 
 inline void Notifier::clear()
 {
     bids.clear();
     asks.clear();
+    levels.clear();
     messages.clear();
 }
 
 inline void Notifier::publish()
 {
-    // write messages to json file
-    std::ofstream file(outfile_);
-    for(auto message : messages)
-        file << message.to_json();
+    if (!publisher_)
+        return;
+    
+    // a line per message, so a message dropped under backpressure never leaves half a line in the file
+    for(const auto& message : messages)
+    {
+        line_.clear();
+        append_json(line_, message);
+        line_ += '\n';
+        publisher_->publish(line_.data(), line_.size());
+    }
+}
+
+inline PublisherStats Notifier::publisher_stats() const
+{
+    return publisher_ ? publisher_->stats() : PublisherStats();
+}
+
+inline std::size_t Notifier::dropped() const
+{
+    return dropped_;
 }
 
 } // namespace notify
@@ -0,0 +1,64 @@
+/// @file recording_listener.h
+/// @brief This is a file to implement a book listener which records the events of a book into the market data feed.
+/// @author Shangwen Sun
+/// @date 05/13/2022
+
+#pragma once
+
+#include "types.h"
+#include "feed.h"
+
+namespace notify
+{
+
+/// @brief The listener of a book whose events go to the market data feed.
+///        Each event is packed into the encoder's preallocated batch on the matching thread, and the encoder's sink,
+///        e.g. an AsyncPublisher, takes whole batches; the matching loop makes no system call of its own.
+///        Until it is attached the listener drops the events, like the NullListener.
+class RecordingListener
+{
+public:
+    /// @brief record the events of the book under symbol_id into encoder, which must outlive the book
+    void attach(FeedEncoder* encoder, lib::t_symbol_id symbol_id);
+
+    void on_add(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+    void on_modify(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+    void on_delete(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_volume level_qty);
+    void on_trade(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+
+private:
+    FeedEncoder* encoder_ = nullptr;
+    lib::t_symbol_id symbol_id_ = lib::NO_SYMBOL_ID;
+};
+
+inline void RecordingListener::attach(FeedEncoder* encoder, lib::t_symbol_id symbol_id)
+{
+    encoder_ = encoder;
+    symbol_id_ = symbol_id;
+}
+
+inline void RecordingListener::on_add(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    if (encoder_)
+        encoder_->add(symbol_id_, order_id, is_buy, price, qty, level_qty);
+}
+
+inline void RecordingListener::on_modify(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    if (encoder_)
+        encoder_->modify(symbol_id_, order_id, is_buy, price, qty, level_qty);
+}
+
+inline void RecordingListener::on_delete(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_volume level_qty)
+{
+    if (encoder_)
+        encoder_->remove(symbol_id_, order_id, is_buy, price, level_qty);
+}
+
+inline void RecordingListener::on_trade(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    if (encoder_)
+        encoder_->trade(symbol_id_, order_id, is_buy, price, qty, level_qty);
+}
+
+} // namespace notify
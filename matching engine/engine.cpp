@@ -8,7 +8,7 @@
 
 using namespace eng;
  
-MatchingEngine::MatchingEngine(const lib::FILE& config_file_name) : lot_size_(100)
+MatchingEngine::MatchingEngine(const lib::FILE& config_file_name)
 {
     // configurate tick size rule
     nlohmann::json j_config;
@@ -26,27 +26,181 @@ MatchingEngine::MatchingEngine(const lib::FILE& config_file_name) : lot_size_(10
 
 
 
-void MatchingEngine::start(const lib::FILE& state_file_last_day)
+void MatchingEngine::add_books()
 {
-    std::vector<lob::Order> GTC_orders_last_day;
+    while (books_.size() < symbols_.size())
+    {
+        const lib::t_symbol_id symbol_id = static_cast<lib::t_symbol_id>(books_.size());
+        books_.emplace_back(new Book(symbols_.name(symbol_id), tick_size_rule_));
+        attach(symbol_id);
+    }
+}
+
 
-    GTC_orders_last_day = parser.load(state_file_last_day, tick_size_rule_, lot_size_);
+
+void MatchingEngine::attach(lib::t_symbol_id symbol_id)
+{
+    // a book matched on this thread forgets the orders it lets go itself, see RouteListener;
+    // a matching thread attaches its own encoder to the books it matches
+    RouteListener& listener = books_[symbol_id]->listener();
+    listener.route_into(threaded_ ? nullptr : &orderSymbols_);
+    listener.feed_into(threaded_ ? nullptr : feed_, symbol_id);
 }
 
 
 
-void MatchingEngine::match_orders(const lib::FILE& order_request_file_name)
+void MatchingEngine::set_feed(notify::FeedEncoder* encoder)
+{
+    feed_ = encoder;
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < books_.size(); ++symbol_id)
+        attach(symbol_id);
+}
+
+
+
+lib::t_symbol_id MatchingEngine::add_symbol(const lib::t_symbol& symbol)
+{
+    const lib::t_symbol_id symbol_id = symbols_.intern(symbol);
+    add_books();
+    return symbol_id;
+}
+
+
+
+void MatchingEngine::set_threaded(bool threaded)
 {
-    lob::OrderParser parser;
-    std::vector<lob::Order> pending_orders;
+    threaded_ = threaded;
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < books_.size(); ++symbol_id)
+        attach(symbol_id);
+}
+
+
 
-    pending_orders = parser.load(order_request_file_name, tick_size_rule_, lot_size_);
+lib::t_symbol_id MatchingEngine::route(lob::Order& order)
+{
+    if (order.status() == lib::OrderStatus::CANCEL)
+    {
+        // the entry stays until the book retires the order, which the cancel may not find there any more
+        const std::uint32_t symbol_id = orderSymbols_.find(order.orderid());
+        if (symbol_id == lob::OrderIndex::npos)
+            return lib::NO_SYMBOL_ID;
+        order.set_symbol_id(symbol_id);
+        return symbol_id;
+    }
     
-    for(auto order : pending_orders){
-        lob.add(order);
+    // a parsed order carries the id the parser interned, only an order built in code is interned here
+    if (order.symbol_id() == lib::NO_SYMBOL_ID)
+        order.set_symbol_id(symbols_.intern(order.symbol()));
+    if (order.symbol_id() == lib::NO_SYMBOL_ID)
+        return lib::NO_SYMBOL_ID;
+    if (order.symbol_id() >= books_.size())
+        add_books();
+    if (!remember(order.orderid(), order.symbol_id()))
+        return lib::NO_SYMBOL_ID;
+    return order.symbol_id();
+}
+
+
+
+bool MatchingEngine::submit(lob::Order& order)
+{
+    const lib::t_symbol_id symbol_id = route(order);
+    if (symbol_id == lib::NO_SYMBOL_ID)
+    {
+        rejects_.add(route_reject(order));
+        return false;
     }
+    return execute(*books_[symbol_id], order);
+}
+
 
-    // matching -> thread II
+
+bool MatchingEngine::submit(const lob::WireOrder& order, lib::t_symbol_id symbol_id)
+{
+    if (order.status_code() == lib::OrderStatus::CANCEL)
+    {
+        symbol_id = orderSymbols_.find(order.orderid());
+        if (symbol_id == lob::OrderIndex::npos)
+        {
+            rejects_.add(lob::RejectReason::UNKNOWN_CANCEL);
+            return false;
+        }
+        return books_[symbol_id]->cancel(order.orderid());
+    }
     
+    if (symbol_id == lib::NO_SYMBOL_ID)
+    {
+        rejects_.add(lob::RejectReason::BAD_SYMBOL_ID);
+        return false;
+    }
+    if (!remember(order.orderid(), symbol_id))
+    {
+        rejects_.add(lob::RejectReason::DUPLICATE_ORDER_ID);
+        return false;
+    }
+    
+    // as execute() does for a decoded order
+    Book& order_book = *books_[symbol_id];
+    const bool filled = order_book.add(order);
+    if (!order_book.contains(order.orderid()))
+        order_book.listener().retire(order.orderid());
+    return filled;
+}
+
+
+
+void MatchingEngine::start(const lib::FILE& state_file_last_day)
+{
+    // GTC orders of the last day go back into the books in the order they were saved
+    rejects_.merge(parse_requests(state_file_last_day, [this](lob::Order& order) { submit(order); }));
 }
 
+
+
+void MatchingEngine::match_orders(const lib::FILE& order_request_file_name)
+{
+    // each order is matched as soon as its line is decoded, nothing of the file is kept
+    rejects_.merge(parse_requests(order_request_file_name, [this](lob::Order& order) { submit(order); }));
+}
+
+
+
+void MatchingEngine::match_wire_orders(const lib::FILE& wire_file_name)
+{
+    lob::WireReader reader(wire_file_name);
+    
+    // the symbol ids of the file are its own, they are resolved to books once per file instead of once per order
+    std::vector<lib::t_symbol_id> symbol_ids(reader.symbol_count());
+    for (lib::t_symbol_id file_symbol_id = 0; file_symbol_id < reader.symbol_count(); ++file_symbol_id)
+        symbol_ids[file_symbol_id] = add_symbol(lib::t_symbol(reader.symbol(file_symbol_id)));
+    
+    // a message is trusted no more than a json line: it is checked in place before it reaches a book
+    std::size_t line = 0;
+    for (const lob::WireOrder& order : reader)
+    {
+        ++line;
+        const lob::RejectReason reason = order.check(tick_size_rule_, lot_size_, symbol_ids.size());
+        if (reason != lob::RejectReason::NONE)
+        {
+            rejects_.add(reason, line);
+            continue;
+        }
+        submit(order, order.status_code() == lib::OrderStatus::CANCEL ? lib::NO_SYMBOL_ID : symbol_ids[order.symbol_id]);
+    }
+}
+
+
+
+PipelineStats MatchingEngine::match_orders(const lib::FILE& order_request_file_name, const PipelineConfig& config)
+{
+    Pipeline pipeline(*this, config);
+    return pipeline.run(order_request_file_name);
+}
+
+
+
+SchedulerStats MatchingEngine::match_orders(const lib::FILE& order_request_file_name, const SchedulerConfig& config)
+{
+    WorkStealingScheduler scheduler(*this, config);
+    return scheduler.run(order_request_file_name);
+}
@@ -5,16 +5,24 @@
 
 #pragma once
 #include <thread>
+#include <memory>
 #include <mutex>  // For std::unique_lock
+#include <vector>
 
 #include "nlohmann/json.hpp"
 
 #include "price4.h"
 #include "types.h"
+#include "symbols.h"
 
 #include "order.h"
 #include "book.h"
+#include "reject.h"
 #include "parser.h"
+#include "wire.h"
+#include "route_listener.h"
+#include "pipeline.h"
+#include "scheduler.h"
 
 
 // - submit orders
@@ -27,14 +35,34 @@ namespace eng
 {
 
 // the matching engine should be a multi-threading engine, one to deal with loading orders, one to deal with matching orders, one to deal with sending feedback to the outside
+// -> match_orders(file, PipelineConfig) runs it as a Pipeline: the parse stage, N matching shards and a publish stage
+// -> match_orders(file, SchedulerConfig) balances skewed symbol flow over a WorkStealingScheduler instead of fixed shards
 class MatchingEngine
 {
 private:
     lib::TickSizeRule tick_size_rule_;
-    lib::t_lot lot_size_;
+    lib::t_lot lot_size_ = 100;
     
-    lob::OrderParser parser; // parser tool to deal with json order files
-    lob::OrderBook lob;
+    lob::OrderParser parser; // parser tool to deal with json order files, streams one file at a time
+    std::size_t parse_threads_ = 1; // threads decoding a request file, 1 streams it on the calling thread
+    
+    lib::SymbolRegistry symbols_; // interned symbols, a symbol id indexes books_
+    std::vector<std::unique_ptr<Book>> books_; // the order book of each symbol, indexed by symbol id
+    lob::OrderIndex orderSymbols_; // symbol id of each order routed to a book and not retired by it, cancel requests carry no symbol
+    bool threaded_ = false; // books are matched on other threads than the routing one
+    notify::FeedEncoder* feed_ = nullptr; // records the events of the books matched on the routing thread
+    lob::RejectStats rejects_; // requests rejected by start and match_orders(file)
+    
+    /// @brief create the books of the symbols interned since the last call
+    void add_books();
+    
+    /// @brief point the listener of a book at the routing index and the feed of the routing thread, or at neither
+    ///        while the book is matched on other threads
+    void attach(lib::t_symbol_id symbol_id);
+    
+    /// @brief remember the book a new order is routed to
+    /// @return false if an order with its id is still in a book, in any symbol
+    bool remember(lib::t_orderid order_id, lib::t_symbol_id symbol_id);
     
 public:
     MatchingEngine() = default;
@@ -44,11 +72,80 @@ public:
     lib::t_lot lot_size();
     lib::TickSizeRule& tick_size_rule();
     
+    /// @brief register a symbol and create its order book, if it is new
+    /// @return the symbol id, which indexes the book table, or NO_SYMBOL_ID if every id is taken
+    lib::t_symbol_id add_symbol(const lib::t_symbol& symbol);
+    
+    /// @brief get the interned symbols
+    const lib::SymbolRegistry& symbols() const;
+    
+    /// @brief get the order book of a registered symbol -> O(1)
+    Book& book(lib::t_symbol_id symbol_id);
+    
+    /// @brief resolve the symbol id of an order, for a cancel the symbol of the order it cancels -> O(1)
+    ///        A parsed order already carries its symbol id, so routing indexes the book table; an order built in code
+    ///        is interned here. A new order is remembered until its book retires it, see execute();
+    ///        only one thread may route at a time.
+    /// @return the symbol id, also stored on the order, or NO_SYMBOL_ID for a cancel of an unknown order
+    ///         or a new order whose id is still in a book
+    lib::t_symbol_id route(lob::Order& order);
+    
+    /// @brief why route() returned NO_SYMBOL_ID for an order
+    lob::RejectReason route_reject(const lob::Order& order) const;
+    
+    /// @brief record the events of the books into encoder while they are matched on the calling thread, nullptr
+    ///        drops them; the pipeline and the scheduler take an encoder per matching thread in their config instead
+    void set_feed(notify::FeedEncoder* encoder);
+    
+    /// @brief let other threads match the books, which then hand the orders they retire to the routing thread;
+    ///        only switched while no other thread matches them
+    void set_threaded(bool threaded);
+    
+    /// @brief forget the orders a book retired so far, on the routing thread; route() does it for the book it routes to
+    void retire(lib::t_symbol_id symbol_id);
+    
+    /// @brief forget the orders every book retired so far, on the routing thread, e.g. while it waits for a matching thread
+    void retire_all();
+    
+    /// @brief number of order ids routed to a book and not retired yet
+    std::size_t routed_orders() const;
+    
+    /// @brief route an order to the book of its symbol, a cancel to the book its order rests in -> O(1)
+    /// @return true if the order was filled or cancelled in a book
+    bool submit(lob::Order& order);
+    
+    /// @brief route an order read from a binary order file, whose symbol was resolved to `symbol_id`; a cancel ignores it -> O(1)
+    /// @return true if the order was filled or cancelled in a book
+    bool submit(const lob::WireOrder& order, lib::t_symbol_id symbol_id);
+    
+    /// @brief decode request files on n threads, the orders still reach the books in file order
+    void set_parse_threads(std::size_t n);
+    
     /// @brief start the engine at the begining of a trading day
     void start(const lib::FILE& state_file_last_day);
     
+    /// @brief stream a request file, handing each valid order to handler(lob::Order&) as soon as its line is decoded
+    /// @return the lines of the file rejected, by reason
+    template <class Handler>
+    const lob::RejectStats& parse_requests(const lib::FILE& order_request_file_name, Handler handler);
+    
+    /// @brief requests rejected by start and the single threaded match_orders so far, by reason
+    const lob::RejectStats& reject_stats() const;
+    
+    /// @brief orders the books refused so far, e.g. reused order ids or remainders a full book dropped, by reason
+    lob::RejectStats book_rejects() const;
+    
     /// @brief match orders from the request file
     void match_orders(const lib::FILE& order_request_file_name);
+    
+    /// @brief match orders from a binary order file, each message handed to its book in place
+    void match_wire_orders(const lib::FILE& wire_file_name);
+    
+    /// @brief match orders from the request file on a parse -> matching shards -> publish thread pipeline
+    PipelineStats match_orders(const lib::FILE& order_request_file_name, const PipelineConfig& config);
+    
+    /// @brief match orders from the request file on a work-stealing pool running per-symbol batches
+    SchedulerStats match_orders(const lib::FILE& order_request_file_name, const SchedulerConfig& config);
     void clear();
 };
 
@@ -62,5 +159,79 @@ inline lib::TickSizeRule& MatchingEngine::tick_size_rule()
     return tick_size_rule_;
 }
 
+template <class Handler>
+const lob::RejectStats& MatchingEngine::parse_requests(const lib::FILE& order_request_file_name, Handler handler)
+{
+    parser.set_symbols(&symbols_);
+    parser.for_each(order_request_file_name, tick_size_rule_, lot_size_, parse_threads_, handler);
+    return parser.reject_stats();
+}
+
+inline const lob::RejectStats& MatchingEngine::reject_stats() const
+{
+    return rejects_;
+}
+
+inline lob::RejectStats MatchingEngine::book_rejects() const
+{
+    lob::RejectStats rejects;
+    for (const auto& order_book : books_)
+        rejects.merge(order_book->rejects());
+    return rejects;
+}
+
+inline void MatchingEngine::set_parse_threads(std::size_t n)
+{
+    parse_threads_ = n == 0 ? 1 : n;
+}
+
+inline const lib::SymbolRegistry& MatchingEngine::symbols() const
+{
+    return symbols_;
+}
+
+inline Book& MatchingEngine::book(lib::t_symbol_id symbol_id)
+{
+    return *books_[symbol_id];
+}
+
+inline bool MatchingEngine::remember(lib::t_orderid order_id, lib::t_symbol_id symbol_id)
+{
+    std::uint32_t resting_symbol_id = orderSymbols_.find(order_id);
+    if (resting_symbol_id != lob::OrderIndex::npos && threaded_)
+    {
+        // the order may have left its book without the router knowing yet
+        retire(resting_symbol_id);
+        resting_symbol_id = orderSymbols_.find(order_id);
+    }
+    if (resting_symbol_id != lob::OrderIndex::npos)
+        return false;
+    orderSymbols_.insert(order_id, symbol_id);
+    return true;
+}
+
+inline lob::RejectReason MatchingEngine::route_reject(const lob::Order& order) const
+{
+    if (order.status() == lib::OrderStatus::CANCEL)
+        return lob::RejectReason::UNKNOWN_CANCEL;
+    return order.symbol_id() == lib::NO_SYMBOL_ID ? lob::RejectReason::BAD_SYMBOL_ID : lob::RejectReason::DUPLICATE_ORDER_ID;
+}
+
+inline void MatchingEngine::retire(lib::t_symbol_id symbol_id)
+{
+    books_[symbol_id]->listener().drain([this](lib::t_orderid order_id) { orderSymbols_.erase(order_id); });
+}
+
+inline void MatchingEngine::retire_all()
+{
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < books_.size(); ++symbol_id)
+        retire(symbol_id);
+}
+
+inline std::size_t MatchingEngine::routed_orders() const
+{
+    return orderSymbols_.size();
+}
+
 }
 
@@ -0,0 +1,412 @@
+//
+//  pipeline.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/3/22.
+//
+
+#include <stdexcept>
+#include <thread>
+
+#include "engine.h"
+#include "pipeline.h"
+
+using namespace eng;
+
+void ShardStats::to_json(nlohmann::json& j) const
+{
+    j["requests"] = requests;
+    j["busy_seconds"] = busy_seconds;
+    j["symbols"] = symbols;
+}
+
+void SymbolStats::to_json(nlohmann::json& j) const
+{
+    j["symbol"] = symbol;
+    j["requests"] = requests;
+    j["busy_seconds"] = busy_seconds;
+    j["shard"] = shard;
+}
+
+void MigrationRecord::to_json(nlohmann::json& j) const
+{
+    j["symbol"] = symbol;
+    j["from"] = from;
+    j["to"] = to;
+    j["at_request"] = at_request;
+    j["imbalance"] = imbalance;
+    j["shard_load_seconds"] = shard_load_seconds;
+    j["symbol_load_seconds"] = symbol_load_seconds;
+}
+
+void PipelineStats::to_json(nlohmann::json& j) const
+{
+    j["requests"] = requests;
+    j["rejected"] = rejected;
+    rejects.to_json(j["rejects"]);
+    j["fills"] = fills;
+    j["cancels"] = cancels;
+    j["seconds"] = seconds;
+
+    j["shards"] = nlohmann::json::array();
+    for (const auto& shard : shards)
+    {
+        nlohmann::json j_shard;
+        shard.to_json(j_shard);
+        j["shards"].emplace_back(j_shard);
+    }
+
+    j["symbols"] = nlohmann::json::array();
+    for (const auto& symbol : symbols)
+    {
+        nlohmann::json j_symbol;
+        symbol.to_json(j_symbol);
+        j["symbols"].emplace_back(j_symbol);
+    }
+
+    j["migrations"] = nlohmann::json::array();
+    for (const auto& migration : migrations)
+    {
+        nlohmann::json j_migration;
+        migration.to_json(j_migration);
+        j["migrations"].emplace_back(j_migration);
+    }
+}
+
+
+
+Pipeline::Pipeline(MatchingEngine& engine, const PipelineConfig& config) : engine_(engine), config_(config)
+{
+    if (config_.shards == 0)
+        config_.shards = 1;
+    if (config_.rebalance_interval == 0)
+        config_.rebalance_interval = 1;
+
+    for (std::size_t shard = 0; shard < config_.shards; ++shard)
+    {
+        requests_.emplace_back(new lib::SpscRing<OrderMessage>(config_.ring_capacity, config_.wait_strategy));
+        reports_.emplace_back(new lib::SpscRing<ReportMessage>(config_.ring_capacity, config_.wait_strategy, &reports_ready_));
+        shard_counters_.emplace_back(new ShardCounters());
+    }
+}
+
+
+
+std::size_t Pipeline::shard_of(lib::t_symbol_id symbol_id)
+{
+    // symbols are dealt to the shards round robin in order of first appearance
+    while (shard_of_.size() <= symbol_id)
+    {
+        shard_of_.push_back(static_cast<std::uint32_t>(shard_of_.size() % config_.shards));
+        symbol_counters_.emplace_back(new SymbolCounters());
+    }
+    return shard_of_[symbol_id];
+}
+
+
+
+PipelineStats Pipeline::run(const lib::FILE& order_request_file_name)
+{
+    stats_ = PipelineStats();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    running_shards_.store(config_.shards);
+    engine_.set_threaded(true);
+    for (std::size_t shard = 0; shard < config_.shards; ++shard)
+        threads.emplace_back(&Pipeline::match_stage, this, shard);
+    threads.emplace_back(&Pipeline::publish_stage, this);
+
+    try
+    {
+        parse_stage(order_request_file_name);
+    }
+    catch (...)
+    {
+        // still stop the other stages before giving up
+        for (std::size_t shard = 0; shard < requests_.size(); ++shard)
+        {
+            OrderMessage message;
+            message.kind = MessageKind::STOP;
+            push_request(shard, std::move(message));
+        }
+        wait_for_shards();
+        for (auto& thread : threads)
+            thread.join();
+        engine_.set_threaded(false);
+        engine_.retire_all();
+        throw;
+    }
+
+    wait_for_shards();
+    for (auto& thread : threads)
+        thread.join();
+    engine_.set_threaded(false);
+    engine_.retire_all();
+    stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // every shard has exited, so the counters are final
+    stats_.shards.resize(config_.shards);
+    for (std::size_t shard = 0; shard < config_.shards; ++shard)
+    {
+        stats_.shards[shard].requests = shard_counters_[shard]->requests.load();
+        stats_.shards[shard].busy_seconds = shard_counters_[shard]->busy_ns.load() * 1e-9;
+    }
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < shard_of_.size(); ++symbol_id)
+    {
+        SymbolStats symbol;
+        symbol.symbol = engine_.symbols().name(symbol_id);
+        symbol.requests = symbol_counters_[symbol_id]->requests.load();
+        symbol.busy_seconds = symbol_counters_[symbol_id]->busy_ns.load() * 1e-9;
+        symbol.shard = shard_of_[symbol_id];
+        ++stats_.shards[symbol.shard].symbols;
+        stats_.symbols.push_back(symbol);
+    }
+    return stats_;
+}
+
+
+
+void Pipeline::parse_stage(const lib::FILE& order_request_file_name)
+{
+    const lob::RejectStats& parse_rejects = engine_.parse_requests(order_request_file_name, [this](lob::Order& order)
+    {
+        const lib::t_symbol_id symbol_id = engine_.route(order);
+        if (symbol_id == lib::NO_SYMBOL_ID)
+        {
+            stats_.rejects.add(engine_.route_reject(order));
+            return;
+        }
+
+        OrderMessage message;
+        const std::size_t shard = shard_of(symbol_id);
+        message.book = &engine_.book(symbol_id);
+        message.counters = symbol_counters_[symbol_id].get();
+        message.order = std::move(order);
+        push_request(shard, std::move(message));
+
+        if (++stats_.requests % config_.rebalance_interval == 0 && config_.rebalance_threshold > 0)
+            rebalance();
+    });
+    stats_.rejects.merge(parse_rejects);
+    stats_.rejected = stats_.rejects.total();
+
+    for (std::size_t shard = 0; shard < requests_.size(); ++shard)
+    {
+        OrderMessage message;
+        message.kind = MessageKind::STOP;
+        push_request(shard, std::move(message));
+    }
+}
+
+
+
+void Pipeline::push_request(std::size_t shard, OrderMessage message)
+{
+    while (!requests_[shard]->try_push(message))
+    {
+        engine_.retire_all();
+        std::this_thread::yield();
+    }
+}
+
+
+
+void Pipeline::wait_for_shards()
+{
+    while (running_shards_.load(std::memory_order_acquire) != 0)
+    {
+        engine_.retire_all();
+        std::this_thread::yield();
+    }
+}
+
+
+
+void Pipeline::rebalance()
+{
+    // matching time of each shard and symbol since the previous check
+    std::vector<std::uint64_t> shard_load(config_.shards, 0);
+    std::vector<std::uint64_t> symbol_load(shard_of_.size(), 0);
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < shard_of_.size(); ++symbol_id)
+    {
+        SymbolCounters& counters = *symbol_counters_[symbol_id];
+        const std::uint64_t busy_ns = counters.busy_ns.load(std::memory_order_relaxed);
+        symbol_load[symbol_id] = busy_ns - counters.checked_busy_ns;
+        counters.checked_busy_ns = busy_ns;
+        shard_load[shard_of_[symbol_id]] += symbol_load[symbol_id];
+    }
+
+    std::size_t busiest = 0, idlest = 0;
+    std::uint64_t total = 0;
+    for (std::size_t shard = 0; shard < config_.shards; ++shard)
+    {
+        total += shard_load[shard];
+        if (shard_load[shard] > shard_load[busiest])
+            busiest = shard;
+        if (shard_load[shard] < shard_load[idlest])
+            idlest = shard;
+    }
+    if (total == 0)
+        return;
+
+    const double imbalance = shard_load[busiest] * static_cast<double>(config_.shards) / total;
+    if (imbalance <= config_.rebalance_threshold)
+        return;
+
+    // the busiest symbol which fits into half the gap, so the idlest shard doesn't end up the busiest
+    const std::uint64_t budget = (shard_load[busiest] - shard_load[idlest]) / 2;
+    lib::t_symbol_id candidate = lib::NO_SYMBOL_ID;
+    for (lib::t_symbol_id symbol_id = 0; symbol_id < shard_of_.size(); ++symbol_id)
+    {
+        if (shard_of_[symbol_id] != busiest || symbol_load[symbol_id] == 0 || symbol_load[symbol_id] > budget)
+            continue;
+        if (candidate == lib::NO_SYMBOL_ID || symbol_load[symbol_id] > symbol_load[candidate])
+            candidate = symbol_id;
+    }
+    if (candidate == lib::NO_SYMBOL_ID)
+        return; // a single hot symbol can't be split
+
+    MigrationRecord record;
+    record.symbol = engine_.symbols().name(candidate);
+    record.from = busiest;
+    record.to = idlest;
+    record.at_request = stats_.requests;
+    record.imbalance = imbalance;
+    for (std::uint64_t load : shard_load)
+        record.shard_load_seconds.push_back(load * 1e-9);
+    record.symbol_load_seconds = symbol_load[candidate] * 1e-9;
+    stats_.migrations.push_back(record);
+
+    migrate(candidate, idlest);
+}
+
+
+
+void Pipeline::migrate(lib::t_symbol_id symbol_id, std::size_t to)
+{
+    // drain: the marker follows the symbol's last request to the old shard, and its report to the publish stage
+    handoff_done_.store(false, std::memory_order_relaxed);
+    OrderMessage message;
+    message.kind = MessageKind::MIGRATE;
+    message.order.set_symbol_id(symbol_id);
+    push_request(shard_of_[symbol_id], std::move(message));
+
+    // hand off: the old shard is done with the book once the publish stage has seen the marker,
+    // its books may retire orders meanwhile
+    while (!handoff_done_.load(std::memory_order_acquire))
+    {
+        engine_.retire_all();
+        std::this_thread::yield();
+    }
+
+    // resume: later requests go to the new shard
+    shard_of_[symbol_id] = static_cast<std::uint32_t>(to);
+}
+
+
+
+void Pipeline::match_stage(std::size_t shard)
+{
+    lib::SpscRing<OrderMessage>& requests = *requests_[shard];
+    lib::SpscRing<ReportMessage>& reports = *reports_[shard];
+    ShardCounters& counters = *shard_counters_[shard];
+    notify::FeedEncoder* feed = shard < config_.feeds.size() ? config_.feeds[shard] : nullptr;
+    OrderMessage message;
+
+    for (;;)
+    {
+        requests.pop(message);
+
+        ReportMessage out;
+        out.kind = message.kind;
+        if (message.kind != MessageKind::ORDER)
+        {
+            out.report.symbol_id = message.order.symbol_id();
+            reports.push(std::move(out));
+            if (message.kind == MessageKind::STOP)
+            {
+                if (feed)
+                    feed->flush();
+                running_shards_.fetch_sub(1, std::memory_order_release);
+                break;
+            }
+            continue;
+        }
+
+        // only this shard touches the book, the parse stage created it before handing it over
+        const auto start = std::chrono::steady_clock::now();
+        Book& book = *message.book;
+        const lob::Order& order = message.order;
+        if (feed)
+            book.listener().feed_into(feed, order.symbol_id()); // the symbol may have migrated from another shard
+        ExecutionReport& report = out.report;
+        report.symbol_id = order.symbol_id();
+        report.order_id = order.orderid();
+        report.cancel = order.status() == lib::OrderStatus::CANCEL;
+        report.filled = execute(book, order);
+        report.resting = book.contains(order.orderid());
+        report.best_bid = book.best_bid();
+        report.best_ask = book.best_ask();
+        const std::uint64_t busy_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        // this shard is the only writer of both counters, so plain stores do
+        SymbolCounters& symbol = *message.counters;
+        symbol.requests.store(symbol.requests.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        symbol.busy_ns.store(symbol.busy_ns.load(std::memory_order_relaxed) + busy_ns, std::memory_order_relaxed);
+        counters.requests.store(counters.requests.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counters.busy_ns.store(counters.busy_ns.load(std::memory_order_relaxed) + busy_ns, std::memory_order_relaxed);
+
+        reports.push(std::move(out));
+    }
+}
+
+
+
+void Pipeline::publish_stage()
+{
+    std::size_t stopped = 0;
+    ReportMessage message;
+
+    auto any_report = [this]()
+    {
+        for (auto& ring : reports_)
+        {
+            if (!ring->empty())
+                return true;
+        }
+        return false;
+    };
+
+    while (stopped < reports_.size())
+    {
+        reports_ready_.wait(config_.wait_strategy, any_report);
+
+        for (auto& ring : reports_)
+        {
+            while (ring->try_pop(message))
+            {
+                if (message.kind == MessageKind::STOP)
+                {
+                    ++stopped;
+                    continue;
+                }
+                if (message.kind == MessageKind::MIGRATE)
+                {
+                    // every report of the symbol from its old shard was published before this one
+                    handoff_done_.store(true, std::memory_order_release);
+                    continue;
+                }
+
+                const ExecutionReport& report = message.report;
+                if (report.cancel)
+                    stats_.cancels += report.filled;
+                else
+                    stats_.fills += report.filled;
+
+                if (config_.on_report)
+                    config_.on_report(report);
+            }
+        }
+    }
+}
@@ -0,0 +1,198 @@
+/// @file pipeline.h
+/// @brief This is a file to implement the thread-per-stage matching pipeline: parse -> matching shards -> publish.
+/// @author Shangwen Sun
+/// @date 05/03/2022
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "boost/noncopyable.hpp"
+#include "nlohmann/json.hpp"
+
+#include "types.h"
+#include "spsc_ring.h"
+
+#include "reject.h"
+#include "order.h"
+#include "book.h"
+#include "feed.h"
+#include "route_listener.h"
+
+namespace eng
+{
+
+class MatchingEngine;
+
+/// @brief The outcome of one request, sent by a matching shard to the publish stage.
+struct ExecutionReport
+{
+    lib::t_symbol_id symbol_id = lib::NO_SYMBOL_ID;
+    lib::t_orderid order_id = 0;
+    bool cancel = false; // the request was a cancel
+    bool filled = false; // a new order traded, or a cancel removed its order
+    bool resting = false; // the order rests in the book afterwards
+    lib::t_price best_bid = 0; // top of the book after the request
+    lib::t_price best_ask = 0;
+};
+
+/// @brief How the pipeline is laid out.
+struct PipelineConfig
+{
+    std::size_t shards = 1; // matching threads, each owning the books of a disjoint set of symbols
+    std::size_t ring_capacity = 4096; // requests or reports in flight between two stages
+    lib::WaitStrategy wait_strategy = lib::WaitStrategy::YIELD;
+    std::function<void(const ExecutionReport&)> on_report; // called in order per symbol on the publish thread, optional
+    std::vector<notify::FeedEncoder*> feeds; // the encoder of each shard, recording the book events it matches, none if empty
+
+    double rebalance_threshold = 0; // move a symbol off the busiest shard when its load exceeds the mean by this factor, 0 never rebalances
+    std::size_t rebalance_interval = 65536; // requests routed between two load checks
+};
+
+/// @brief Load of one matching shard over a run.
+struct ShardStats
+{
+    std::size_t requests = 0; // requests matched
+    double busy_seconds = 0; // time spent matching
+    std::size_t symbols = 0; // symbols owned at the end of the run
+
+    void to_json(nlohmann::json& j) const;
+};
+
+/// @brief Load of one symbol over a run.
+struct SymbolStats
+{
+    lib::t_symbol symbol;
+    std::size_t requests = 0; // requests matched
+    double busy_seconds = 0; // time spent matching
+    std::size_t shard = 0; // the shard owning it at the end of the run
+
+    void to_json(nlohmann::json& j) const;
+};
+
+/// @brief Why and where a symbol was moved between shards.
+struct MigrationRecord
+{
+    lib::t_symbol symbol;
+    std::size_t from = 0; // the busiest shard of the check
+    std::size_t to = 0; // the idlest shard of the check
+    std::size_t at_request = 0; // requests routed before the move
+    double imbalance = 0; // busiest shard load over the mean shard load
+    std::vector<double> shard_load_seconds; // matching time of each shard since the previous check
+    double symbol_load_seconds = 0; // matching time of the symbol since the previous check
+
+    void to_json(nlohmann::json& j) const;
+};
+
+/// @brief Counters of one pipeline run.
+struct PipelineStats
+{
+    std::size_t requests = 0; // requests handed to the shards
+    std::size_t rejected = 0; // lines which failed to parse or cancels of unknown orders
+    lob::RejectStats rejects; // the rejected requests by reason
+    std::size_t fills = 0; // new orders which traded
+    std::size_t cancels = 0; // cancels which removed an order
+    std::vector<ShardStats> shards;
+    std::vector<SymbolStats> symbols; // indexed by symbol id
+    std::vector<MigrationRecord> migrations;
+    double seconds = 0; // wall time from the first line read to the last report published
+
+    void to_json(nlohmann::json& j) const;
+};
+
+/// @brief Runs a request file through three kinds of stages connected by SPSC rings:
+///        the calling thread parses and routes, each shard thread matches the books of its symbols,
+///        and a publish thread drains the reports of every shard.
+///        A symbol is owned by one shard at a time, so its requests are matched in file order by a single thread.
+///        With rebalancing on, the parse stage compares the matching time of the shards every rebalance_interval
+///        requests and moves a symbol from the busiest to the idlest shard at a safe point: it sends a MIGRATE marker
+///        after the symbol's last request to the old shard, waits until the publish stage has seen the marker
+///        (so every earlier request was matched and reported), then routes the symbol's requests to the new shard.
+class Pipeline : public boost::noncopyable
+{
+public:
+    Pipeline(MatchingEngine& engine, const PipelineConfig& config);
+
+    /// @brief match every request of a file, returns once every report was published
+    PipelineStats run(const lib::FILE& order_request_file_name);
+
+private:
+    enum class MessageKind
+    {
+        ORDER = 0,
+        MIGRATE = 1, // the symbol leaves the shard, every earlier request of it was matched
+        STOP = 2, // no more requests, the shard exits
+    };
+
+    /// @brief load counters of a symbol, written by the shard owning it and read by the parse stage
+    struct SymbolCounters
+    {
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> busy_ns{0};
+        std::uint64_t checked_busy_ns = 0; // busy_ns at the previous load check, parse stage only
+    };
+
+    /// @brief load counters of a shard, written by the shard and read by the parse stage
+    struct alignas(lib::CACHE_LINE_SIZE) ShardCounters
+    {
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> busy_ns{0};
+    };
+
+    struct OrderMessage
+    {
+        MessageKind kind = MessageKind::ORDER;
+        Book* book = nullptr;
+        SymbolCounters* counters = nullptr;
+        lob::Order order;
+    };
+
+    struct ReportMessage
+    {
+        MessageKind kind = MessageKind::ORDER;
+        ExecutionReport report;
+    };
+
+    /// @brief the shard owning the books of a symbol
+    std::size_t shard_of(lib::t_symbol_id symbol_id);
+
+    /// @brief compare the shard loads since the previous check and move one symbol if they are out of balance
+    void rebalance();
+
+    /// @brief move a symbol to another shard once the old one matched and reported all its requests
+    void migrate(lib::t_symbol_id symbol_id, std::size_t to);
+
+    /// @brief push a message to a shard; while its ring is full the parse stage forgets the orders the books
+    ///        retired, since a shard may itself wait for the parse stage to make room for them
+    void push_request(std::size_t shard, OrderMessage message);
+
+    /// @brief wait for every shard to exit, forgetting the orders the books retire meanwhile
+    void wait_for_shards();
+
+    void parse_stage(const lib::FILE& order_request_file_name);
+    void match_stage(std::size_t shard);
+    void publish_stage();
+
+private:
+    MatchingEngine& engine_;
+    PipelineConfig config_;
+
+    std::vector<std::unique_ptr<lib::SpscRing<OrderMessage>>> requests_; // parse stage -> each shard
+    std::vector<std::unique_ptr<lib::SpscRing<ReportMessage>>> reports_; // each shard -> publish stage
+    lib::WaitSignal reports_ready_; // raised by any shard's report ring
+
+    std::vector<std::uint32_t> shard_of_; // shard of each symbol id
+    std::vector<std::unique_ptr<SymbolCounters>> symbol_counters_; // indexed by symbol id, grown by the parse stage
+    std::vector<std::unique_ptr<ShardCounters>> shard_counters_;
+
+    std::atomic<bool> handoff_done_{false}; // the publish stage saw the MIGRATE marker
+    std::atomic<std::size_t> running_shards_{0}; // shards which did not exit yet
+
+    PipelineStats stats_;
+};
+
+} // namespace eng
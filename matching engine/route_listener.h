@@ -0,0 +1,124 @@
+/// @file route_listener.h
+/// @brief This is a file to implement the listener of the engine's books, which tells the router the orders a book let go
+///        and records the book's events into the market data feed.
+/// @author Shangwen Sun
+/// @date 05/15/2022
+
+#pragma once
+
+#include "types.h"
+#include "spsc_ring.h"
+
+#include "order.h"
+#include "order_index.h"
+#include "book.h"
+#include "recording_listener.h"
+
+namespace eng
+{
+
+#define RETIRED_RING_CAPACITY 4096 // order ids a book can retire before its thread waits for the router
+
+/// @brief The listener of a book of the engine: it retires the id of every order which leaves the book, and of every
+///        new order which never rested, so the router can forget which book the id was sent to.
+///        A book matched on the routing thread erases the ids from the routing index itself. A book matched on
+///        another thread hands them over a ring, that thread being the producer and the routing thread the consumer;
+///        when the router is a whole ring behind, the book's thread waits for it instead of allocating.
+///        Every event also goes to a RecordingListener, so the books of the engine feed the market data publisher
+///        once an encoder of the thread matching them is attached.
+class RouteListener
+{
+public:
+    RouteListener() : retired_(RETIRED_RING_CAPACITY) {}
+
+    void on_add(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+    void on_modify(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+    void on_delete(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_volume level_qty);
+    void on_trade(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty);
+    
+    /// @brief record the events of the book under symbol_id into encoder, nullptr drops them;
+    ///        the encoder must belong to the thread matching the book from now on
+    void feed_into(notify::FeedEncoder* encoder, lib::t_symbol_id symbol_id);
+
+    /// @brief erase retired ids from routes right away, or hand them over the ring if routes is null;
+    ///        only switched while no other thread matches the book
+    void route_into(lob::OrderIndex* routes);
+
+    /// @brief the book is done with the order of order_id, on the book's thread
+    void retire(lib::t_orderid order_id);
+
+    /// @brief hand the ids retired over the ring to handler(lib::t_orderid), on the routing thread
+    template <class Handler>
+    void drain(Handler handler);
+
+private:
+    lob::OrderIndex* routes_ = nullptr;
+    lib::SpscRing<lib::t_orderid> retired_;
+    notify::RecordingListener feed_;
+};
+
+/// @brief A book of the engine.
+typedef lob::BasicOrderBook<RouteListener> Book;
+
+inline void RouteListener::on_add(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    feed_.on_add(order_id, is_buy, price, qty, level_qty);
+}
+
+inline void RouteListener::on_modify(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    feed_.on_modify(order_id, is_buy, price, qty, level_qty);
+}
+
+inline void RouteListener::on_delete(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_volume level_qty)
+{
+    feed_.on_delete(order_id, is_buy, price, level_qty);
+    retire(order_id);
+}
+
+inline void RouteListener::on_trade(lib::t_orderid order_id, bool is_buy, lib::t_price price, lib::t_quantity qty, lib::t_volume level_qty)
+{
+    feed_.on_trade(order_id, is_buy, price, qty, level_qty);
+}
+
+inline void RouteListener::feed_into(notify::FeedEncoder* encoder, lib::t_symbol_id symbol_id)
+{
+    feed_.attach(encoder, symbol_id);
+}
+
+inline void RouteListener::route_into(lob::OrderIndex* routes)
+{
+    routes_ = routes;
+}
+
+inline void RouteListener::retire(lib::t_orderid order_id)
+{
+    if (routes_)
+        routes_->erase(order_id);
+    else
+        retired_.push(order_id);
+}
+
+template <class Handler>
+void RouteListener::drain(Handler handler)
+{
+    lib::t_orderid order_id;
+    while (retired_.try_pop(order_id))
+        handler(order_id);
+}
+
+/// @brief match a routed request in its book, on the thread which owns the book;
+///        a new order which does not rest is retired at once, a resting one when it leaves the book
+/// @return true if the order was filled or cancelled
+inline bool execute(Book& book, const lob::Order& order)
+{
+    if (order.status() == lib::OrderStatus::CANCEL)
+        return book.cancel(order.orderid());
+
+    const bool filled = book.add(order);
+    if (!book.contains(order.orderid()))
+        book.listener().retire(order.orderid());
+    return filled;
+}
+
+} // namespace eng
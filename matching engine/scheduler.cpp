@@ -0,0 +1,262 @@
+//
+//  scheduler.cpp
+//  financial_exchange_prototype
+//
+//  Created by Sun Shangwen on 5/4/22.
+//
+
+#include <thread>
+
+#include "engine.h"
+#include "scheduler.h"
+
+using namespace eng;
+
+void SchedulerStats::to_json(nlohmann::json& j) const
+{
+    j["requests"] = requests;
+    j["rejected"] = rejected;
+    rejects.to_json(j["rejects"]);
+    j["fills"] = fills;
+    j["batches"] = batches;
+    j["steals"] = steals;
+    j["worker_requests"] = worker_requests;
+    j["seconds"] = seconds;
+}
+
+
+
+WorkStealingScheduler::WorkStealingScheduler(MatchingEngine& engine, const SchedulerConfig& config) : engine_(engine), config_(config)
+{
+    if (config_.workers == 0)
+        config_.workers = 1;
+    if (config_.batch_size == 0)
+        config_.batch_size = 1;
+
+    for (std::size_t worker = 0; worker < config_.workers; ++worker)
+        workers_.emplace_back(new Worker());
+}
+
+
+
+SchedulerStats WorkStealingScheduler::run(const lib::FILE& order_request_file_name)
+{
+    SchedulerStats stats;
+    pending_.store(0);
+    done_.store(false);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    engine_.set_threaded(true);
+    for (std::size_t worker = 0; worker < config_.workers; ++worker)
+        threads.emplace_back(&WorkStealingScheduler::work, this, worker);
+
+    try
+    {
+        parse_stage(order_request_file_name, stats);
+    }
+    catch (...)
+    {
+        // let the workers drain what was queued and exit before giving up
+        done_.store(true);
+        work_ready_.notify();
+        wait_for_workers();
+        for (auto& thread : threads)
+            thread.join();
+        engine_.set_threaded(false);
+        engine_.retire_all();
+        throw;
+    }
+
+    wait_for_workers();
+    for (auto& thread : threads)
+        thread.join();
+    engine_.set_threaded(false);
+    engine_.retire_all();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto& worker : workers_)
+    {
+        stats.fills += worker->fills;
+        stats.batches += worker->batches;
+        stats.steals += worker->steals;
+        stats.worker_requests.push_back(worker->requests);
+        worker->fills = worker->batches = worker->steals = worker->requests = 0;
+    }
+    return stats;
+}
+
+
+
+void WorkStealingScheduler::parse_stage(const lib::FILE& order_request_file_name, SchedulerStats& stats)
+{
+    const lob::RejectStats& parse_rejects = engine_.parse_requests(order_request_file_name, [&](lob::Order& order)
+    {
+        const lib::t_symbol_id symbol_id = engine_.route(order);
+        if (symbol_id == lib::NO_SYMBOL_ID)
+        {
+            stats.rejects.add(engine_.route_reject(order));
+            return;
+        }
+
+        if (queues_.size() <= symbol_id)
+            queues_.resize(symbol_id + 1);
+        if (!queues_[symbol_id])
+        {
+            queues_[symbol_id].reset(new SymbolQueue(symbol_id, engine_.book(symbol_id), config_.queue_capacity, config_.wait_strategy));
+            queues_[symbol_id]->owner.store(static_cast<std::uint32_t>(symbol_id % config_.workers));
+        }
+
+        SymbolQueue& queue = *queues_[symbol_id];
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        // a full queue is only drained by a worker, which may itself wait for this thread to forget what its book retired
+        while (!queue.requests.try_push(order))
+        {
+            engine_.retire_all();
+            std::this_thread::yield();
+        }
+        ++stats.requests;
+
+        // pairs with the fence in run_batch: either we see the queue unscheduled or its worker sees the new order
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!queue.scheduled.load(std::memory_order_relaxed) && !queue.scheduled.exchange(true))
+            schedule(queue, queue.owner.load(std::memory_order_relaxed));
+    });
+    stats.rejects.merge(parse_rejects);
+    stats.rejected = stats.rejects.total();
+
+    done_.store(true);
+    work_ready_.notify();
+}
+
+
+
+void WorkStealingScheduler::wait_for_workers()
+{
+    // a worker matches an order before counting it, so the books retire nothing once none is pending
+    while (pending_.load(std::memory_order_acquire) != 0)
+    {
+        engine_.retire_all();
+        std::this_thread::yield();
+    }
+}
+
+
+
+void WorkStealingScheduler::schedule(SymbolQueue& queue, std::size_t worker)
+{
+    Worker& target = *workers_[worker];
+    {
+        std::lock_guard<std::mutex> guard(target.lock);
+        target.tasks.push_back(&queue);
+        target.size.store(target.tasks.size(), std::memory_order_relaxed);
+    }
+    work_ready_.notify();
+}
+
+
+
+WorkStealingScheduler::SymbolQueue* WorkStealingScheduler::next_task(std::size_t worker)
+{
+    Worker& self = *workers_[worker];
+    if (self.size.load(std::memory_order_relaxed) != 0)
+    {
+        std::lock_guard<std::mutex> guard(self.lock);
+        if (!self.tasks.empty())
+        {
+            SymbolQueue* queue = self.tasks.front();
+            self.tasks.pop_front();
+            self.size.store(self.tasks.size(), std::memory_order_relaxed);
+            return queue;
+        }
+    }
+
+    // steal the most recently scheduled queue of the next busy worker
+    for (std::size_t i = 1; i < workers_.size(); ++i)
+    {
+        Worker& victim = *workers_[(worker + i) % workers_.size()];
+        if (victim.size.load(std::memory_order_relaxed) == 0)
+            continue;
+
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            SymbolQueue* queue = victim.tasks.back();
+            victim.tasks.pop_back();
+            victim.size.store(victim.tasks.size(), std::memory_order_relaxed);
+            ++self.steals;
+            return queue;
+        }
+    }
+    return nullptr;
+}
+
+
+
+void WorkStealingScheduler::run_batch(SymbolQueue& queue, std::size_t worker)
+{
+    Worker& self = *workers_[worker];
+    queue.owner.store(static_cast<std::uint32_t>(worker), std::memory_order_relaxed);
+
+    // this worker holds the queue, so it is the only one matching the book
+    if (worker < config_.feeds.size())
+        queue.book.listener().feed_into(config_.feeds[worker], queue.symbol_id);
+    lob::Order order;
+    std::size_t matched = 0;
+    while (matched < config_.batch_size && queue.requests.try_pop(order))
+    {
+        if (order.status() == lib::OrderStatus::CANCEL)
+            queue.book.cancel(order.orderid());
+        else
+            self.fills += execute(queue.book, order);
+        ++matched;
+    }
+    self.requests += matched;
+    ++self.batches;
+
+    if (pending_.fetch_sub(matched, std::memory_order_acq_rel) == matched && done_.load())
+        work_ready_.notify();
+
+    if (queue.requests.empty())
+    {
+        // release the queue, unless the parse thread pushed an order it did not schedule
+        queue.scheduled.store(false, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue.requests.empty() || queue.scheduled.exchange(true))
+            return;
+    }
+    schedule(queue, worker);
+}
+
+
+
+void WorkStealingScheduler::work(std::size_t worker)
+{
+    auto ready = [this]()
+    {
+        if (done_.load() && pending_.load() == 0)
+            return true;
+        for (auto& other : workers_)
+        {
+            if (other->size.load(std::memory_order_relaxed) != 0)
+                return true;
+        }
+        return false;
+    };
+
+    for (;;)
+    {
+        if (SymbolQueue* queue = next_task(worker))
+        {
+            run_batch(*queue, worker);
+            continue;
+        }
+        if (done_.load() && pending_.load() == 0)
+        {
+            if (worker < config_.feeds.size() && config_.feeds[worker])
+                config_.feeds[worker]->flush();
+            return;
+        }
+        work_ready_.wait(config_.wait_strategy, ready);
+    }
+}
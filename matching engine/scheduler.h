@@ -0,0 +1,124 @@
+/// @file scheduler.h
+/// @brief This is a file to implement a work-stealing scheduler matching per-symbol batches of orders.
+/// @author Shangwen Sun
+/// @date 05/04/2022
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "boost/noncopyable.hpp"
+#include "nlohmann/json.hpp"
+
+#include "types.h"
+#include "spsc_ring.h"
+
+#include "reject.h"
+#include "order.h"
+#include "book.h"
+#include "feed.h"
+#include "route_listener.h"
+
+namespace eng
+{
+
+class MatchingEngine;
+
+/// @brief How the work-stealing pool is laid out.
+struct SchedulerConfig
+{
+    std::size_t workers = 1; // matching threads
+    std::size_t batch_size = 64; // orders of one symbol matched before its queue goes back to the pool
+    std::size_t queue_capacity = 1024; // orders in flight per symbol
+    lib::WaitStrategy wait_strategy = lib::WaitStrategy::YIELD;
+    std::vector<notify::FeedEncoder*> feeds; // the encoder of each worker, recording the book events it matches, none if empty
+};
+
+/// @brief Counters of one scheduler run.
+struct SchedulerStats
+{
+    std::size_t requests = 0; // requests handed to the pool
+    std::size_t rejected = 0; // lines which failed to parse or cancels of unknown orders
+    lob::RejectStats rejects; // the rejected requests by reason
+    std::size_t fills = 0; // new orders which traded
+    std::size_t batches = 0; // symbol batches run
+    std::size_t steals = 0; // symbol queues taken from another worker
+    std::vector<std::size_t> worker_requests; // requests matched by each worker
+    double seconds = 0; // wall time from the first line read to the last order matched
+
+    void to_json(nlohmann::json& j) const;
+};
+
+/// @brief Matches a request file on a pool of workers with per-symbol queues.
+///        The calling thread parses and appends each order to the queue of its symbol. A queue with orders is
+///        scheduled on exactly one worker deque at a time, so a book is only ever matched by the worker holding
+///        its queue and needs no lock. A worker runs the queue at the front of its own deque for a batch, then puts
+///        it back at the end if orders remain; idle workers steal whole symbol queues from the end of the others' deques.
+class WorkStealingScheduler : public boost::noncopyable
+{
+public:
+    WorkStealingScheduler(MatchingEngine& engine, const SchedulerConfig& config);
+
+    /// @brief match every request of a file, returns once every order was matched
+    SchedulerStats run(const lib::FILE& order_request_file_name);
+
+private:
+    /// @brief the pending orders of one symbol
+    struct SymbolQueue
+    {
+        SymbolQueue(lib::t_symbol_id symbol, Book& order_book, std::size_t capacity, lib::WaitStrategy strategy)
+            : symbol_id(symbol), book(order_book), requests(capacity, strategy) {}
+
+        lib::t_symbol_id symbol_id;
+        Book& book;
+        lib::SpscRing<lob::Order> requests; // the parse thread pushes, the worker holding the queue pops
+        std::atomic<bool> scheduled{false}; // on a deque or being run
+        std::atomic<std::uint32_t> owner{0}; // the worker which ran it last, it goes back to its deque
+    };
+
+    /// @brief a worker's deque of scheduled symbol queues and its counters
+    struct alignas(lib::CACHE_LINE_SIZE) Worker
+    {
+        std::mutex lock;
+        std::deque<SymbolQueue*> tasks;
+        std::atomic<std::size_t> size{0}; // tasks.size(), readable without the lock
+
+        std::size_t requests = 0;
+        std::size_t fills = 0;
+        std::size_t batches = 0;
+        std::size_t steals = 0;
+    };
+
+    /// @brief put a symbol queue at the end of a worker's deque
+    void schedule(SymbolQueue& queue, std::size_t worker);
+
+    /// @brief take the next symbol queue of a worker's own deque, or steal one from another worker
+    SymbolQueue* next_task(std::size_t worker);
+
+    /// @brief match up to batch_size orders of a symbol queue
+    void run_batch(SymbolQueue& queue, std::size_t worker);
+
+    /// @brief wait for the workers to match every queued order, forgetting the orders the books retire meanwhile
+    void wait_for_workers();
+
+    void parse_stage(const lib::FILE& order_request_file_name, SchedulerStats& stats);
+    void work(std::size_t worker);
+
+private:
+    MatchingEngine& engine_;
+    SchedulerConfig config_;
+
+    std::vector<std::unique_ptr<SymbolQueue>> queues_; // indexed by symbol id, only touched by the parse thread
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::atomic<std::size_t> pending_{0}; // orders queued and not matched yet
+    std::atomic<bool> done_{false}; // the parse thread queued its last order
+    lib::WaitSignal work_ready_; // raised when a queue is scheduled or the run is over
+};
+
+} // namespace eng